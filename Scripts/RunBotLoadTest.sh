@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+# Starts a headless dedicated server and ramps up load test bots against it, then writes the
+# server's players vs. tick time curve (see UDServerLoadSubsystem) to a CSV.
+#
+# Usage: Scripts/RunBotLoadTest.sh [Bots=16] [RampSeconds=60] [HoldSeconds=120]
+#   UE_EDITOR  UnrealEditor(-Cmd) binary to run, defaults to UnrealEditor on the PATH
+#   MAP        map to load, defaults to the game's default map
+#   PORT       server port, defaults to 7777
+#   OUT        CSV to write, defaults to Saved/LoadTest/ServerLoad_<date>.csv
+
+set -euo pipefail
+
+BOTS=${1:-16}
+RAMP_SECONDS=${2:-60}
+HOLD_SECONDS=${3:-120}
+
+PROJECT_DIR=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
+PROJECT="$PROJECT_DIR/Dishonored.uproject"
+UE_EDITOR=${UE_EDITOR:-UnrealEditor}
+MAP=${MAP:-/Game/FirstPerson/Maps/FirstPersonMap}
+PORT=${PORT:-7777}
+OUT=${OUT:-$PROJECT_DIR/Saved/LoadTest/ServerLoad_$(date +%Y%m%d_%H%M%S).csv}
+SERVER_LOG=LoadTestServer.log
+
+PIDS=()
+cleanup()
+{
+	# Bots first, so the server's final report sees them leave rather than vanish
+	for PID in "${PIDS[@]:1}"; do kill "$PID" 2>/dev/null || true; done
+	if [ ${#PIDS[@]} -gt 0 ]; then
+		kill -INT "${PIDS[0]}" 2>/dev/null || true
+		wait "${PIDS[0]}" 2>/dev/null || true
+	fi
+}
+trap cleanup EXIT
+
+echo "Starting server on port $PORT"
+"$UE_EDITOR" "$PROJECT" "$MAP" -server -nullrhi -nosound -unattended -port="$PORT" -log="$SERVER_LOG" >/dev/null 2>&1 &
+PIDS+=($!)
+sleep 20
+
+# Spread the bots evenly over the ramp, so the curve gets samples at every player count
+INTERVAL=$(( BOTS > 1 ? RAMP_SECONDS / (BOTS - 1) : 0 ))
+for (( BOT = 1; BOT <= BOTS; BOT++ )); do
+	echo "Starting bot $BOT/$BOTS"
+	"$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -DBot -nullrhi -nosound -unattended -log="LoadTestBot$BOT.log" >/dev/null 2>&1 &
+	PIDS+=($!)
+	if [ "$BOT" -lt "$BOTS" ]; then sleep "$INTERVAL"; fi
+done
+
+echo "Holding $BOTS bots for ${HOLD_SECONDS}s"
+sleep "$HOLD_SECONDS"
+
+cleanup
+trap - EXIT
+
+# The server logs the whole curve when its world ends, keep only that last report
+mkdir -p "$(dirname "$OUT")"
+awk -F'Server load curve: ' 'NF > 1 { if ($2 ~ /^Players,/) { n = 0 } lines[n++] = $2 } END { for (i = 0; i < n; i++) print lines[i] }' \
+	"$PROJECT_DIR/Saved/Logs/$SERVER_LOG" > "$OUT"
+echo "Wrote $OUT"
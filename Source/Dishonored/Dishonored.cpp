@@ -3,5 +3,6 @@
 #include "Dishonored.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogDishonored);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Dishonored, "Dishonored" );
- 
\ No newline at end of file
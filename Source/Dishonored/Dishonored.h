@@ -3,3 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogDishonored, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Dishonored"), STATGROUP_Dishonored, STATCAT_Advanced);
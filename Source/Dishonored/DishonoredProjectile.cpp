@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "DishonoredProjectile.h"
+#include "TP_WeaponComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
 
@@ -29,15 +30,75 @@ ADishonoredProjectile::ADishonoredProjectile()
 
 	// Die after 3 seconds by default
 	InitialLifeSpan = 3.0f;
+
+	// Shots fired on a server are seen by the players near them, see UDReplicationGraph
+	bReplicates = true;
+	SetReplicatingMovement(true);
+}
+
+void ADishonoredProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// In fixed step mode the subsystem moves us in fixed steps instead of the frame delta
+	UDFixedStepSubsystem* FixedStepSubsystem = GetWorld()->GetSubsystem<UDFixedStepSubsystem>();
+	if (FixedStepSubsystem != nullptr && UDFixedStepSubsystem::IsFixedStepEnabled())
+	{
+		for (const USceneComponent* Child : CollisionComp->GetAttachChildren())
+		{
+			VisualRelativeLocations.Add(Child->GetRelativeLocation());
+		}
+
+		ProjectileMovement->SetComponentTickEnabled(false);
+		FixedStepSubsystem->RegisterActor(this);
+	}
+}
+
+void ADishonoredProjectile::FixedStep(float StepDelta)
+{
+	ProjectileMovement->TickComponent(StepDelta, LEVELTICK_All, &ProjectileMovement->PrimaryComponentTick);
+}
+
+void ADishonoredProjectile::HashFixedStepState(uint32& InOutHash) const
+{
+	const FVector Location = GetActorLocation();
+	InOutHash = FCrc::MemCrc32(&Location, sizeof(Location), InOutHash);
+	InOutHash = FCrc::MemCrc32(&ProjectileMovement->Velocity, sizeof(FVector), InOutHash);
+}
+
+void ADishonoredProjectile::SetPresentationOffset(const FVector& Offset)
+{
+	// Only the visible children move, collision stays where the simulation put it
+	const FVector LocalOffset = GetActorTransform().InverseTransformVectorNoScale(Offset);
+	const TArray<TObjectPtr<USceneComponent>>& Children = CollisionComp->GetAttachChildren();
+	for (int32 Index = 0; Index < Children.Num() && Index < VisualRelativeLocations.Num(); ++Index)
+	{
+		Children[Index]->SetRelativeLocation(VisualRelativeLocations[Index] + LocalOffset);
+	}
 }
 
 void ADishonoredProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	// Only add impulse and destroy projectile if we hit a physics
-	if ((OtherActor != nullptr) && (OtherActor != this) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
+	if (UTP_WeaponComponent* Weapon = SourceWeapon.Get())
 	{
-		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
+		Weapon->PlayImpactSound(Hit.ImpactPoint);
+	}
 
+	// Only destroy projectile if we hit a physics
+	if (ApplyImpact(this, OtherActor, OtherComp, GetVelocity(), GetActorLocation()))
+	{
 		Destroy();
 	}
+}
+
+bool ADishonoredProjectile::ApplyImpact(AActor* Shooter, AActor* OtherActor, UPrimitiveComponent* OtherComp, const FVector& ImpactVelocity, const FVector& ImpactLocation)
+{
+	// Only add impulse if we hit a physics
+	if ((OtherActor != nullptr) && (OtherActor != Shooter) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
+	{
+		OtherComp->AddImpulseAtLocation(ImpactVelocity * 100.0f, ImpactLocation);
+		return true;
+	}
+
+	return false;
 }
\ No newline at end of file
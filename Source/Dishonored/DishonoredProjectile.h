@@ -4,13 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Gameplay/Simulation/DFixedStepSubsystem.h"
 #include "DishonoredProjectile.generated.h"
 
 class USphereComponent;
 class UProjectileMovementComponent;
+class UTP_WeaponComponent;
 
 UCLASS(config=Game)
-class ADishonoredProjectile : public AActor
+class ADishonoredProjectile : public AActor, public IDFixedStepActor
 {
 	GENERATED_BODY()
 
@@ -25,13 +27,33 @@ class ADishonoredProjectile : public AActor
 public:
 	ADishonoredProjectile();
 
+	virtual void BeginPlay() override;
+
+	// IDFixedStepActor
+	virtual void FixedStep(float StepDelta) override;
+	virtual void HashFixedStepState(uint32& InOutHash) const override;
+	virtual void SetPresentationOffset(const FVector& Offset) override;
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/** Sets the weapon that fired us, impact sounds are played through its voices */
+	void SetSourceWeapon(UTP_WeaponComponent* Weapon) { SourceWeapon = Weapon; }
+
+	/** Impact handling shared by projectiles and traced shots. Returns true if the shot was stopped by what it hit */
+	static bool ApplyImpact(AActor* Shooter, AActor* OtherActor, UPrimitiveComponent* OtherComp, const FVector& ImpactVelocity, const FVector& ImpactLocation);
+
 	/** Returns CollisionComp subobject **/
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+private:
+	/** Weapon that fired this projectile */
+	TWeakObjectPtr<UTP_WeaponComponent> SourceWeapon;
+
+	/** Where the visible parts sit relative to the collision, before fixed step interpolation */
+	TArray<FVector> VisualRelativeLocations;
 };
 
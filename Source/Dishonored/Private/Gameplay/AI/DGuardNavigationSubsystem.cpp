@@ -0,0 +1,369 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/AI/DGuardNavigationSubsystem.h"
+#include "Dishonored.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Guard Navigation Tick"), STAT_DGuardNavTick, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Guard Navigation Requests"), STAT_DGuardNavRequests, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Guard Navigation Cache Hits"), STAT_DGuardNavCacheHits, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Guard Navigation Queries"), STAT_DGuardNavQueries, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Guard Navigation Queued"), STAT_DGuardNavQueued, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Guard Navigation In Flight"), STAT_DGuardNavInFlight, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Guard Navigation Cached Paths"), STAT_DGuardNavCachedPaths, STATGROUP_Dishonored);
+
+namespace DGuardNav
+{
+	static int32 MaxSubmitsPerFrame = 8;
+	static FAutoConsoleVariableRef CVarMaxSubmitsPerFrame(
+		TEXT("d.GuardNav.MaxSubmitsPerFrame"),
+		MaxSubmitsPerFrame,
+		TEXT("Most guard path queries handed to async path finding per frame"));
+
+	static int32 MaxQueriesInFlight = 32;
+	static FAutoConsoleVariableRef CVarMaxQueriesInFlight(
+		TEXT("d.GuardNav.MaxQueriesInFlight"),
+		MaxQueriesInFlight,
+		TEXT("Most guard path queries running at once, the rest wait in the queue"));
+
+	static float CellSize = 100.f;
+	static FAutoConsoleVariableRef CVarCellSize(
+		TEXT("d.GuardNav.CellSize"),
+		CellSize,
+		TEXT("Size of the cells path starts and goals are snapped to when looking for a cached path"));
+
+	static int32 MaxCachedPaths = 512;
+	static FAutoConsoleVariableRef CVarMaxCachedPaths(
+		TEXT("d.GuardNav.MaxCachedPaths"),
+		MaxCachedPaths,
+		TEXT("Most paths kept in the guard path cache, the least recently used is dropped past this"));
+
+	/** How often benchmark guards ask for a new path, about as often as a chasing guard repaths */
+	constexpr float BenchmarkRepathInterval = 0.25f;
+	/** How fast benchmark guards move along their paths */
+	constexpr float BenchmarkGuardSpeed = 400.f;
+	/** How often the benchmark target moves when there is no player to chase */
+	constexpr float BenchmarkTargetMoveInterval = 2.f;
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkCommand(
+		TEXT("d.GuardNav.Benchmark"),
+		TEXT("d.GuardNav.Benchmark [NumGuards=50] [Seconds=20]: simulates guards chasing the player and logs path queries per second and cache hit rate"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (UDGuardNavigationSubsystem* GuardNav = World ? World->GetSubsystem<UDGuardNavigationSubsystem>() : nullptr)
+			{
+				const int32 NumGuards = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50;
+				const float Duration = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 20.f;
+				GuardNav->StartBenchmark(FMath::Max(NumGuards, 1), FMath::Max(Duration, 1.f));
+			}
+		}));
+
+	/** Returns the point Distance along Path from its start */
+	FVector AdvanceAlongPath(const FNavigationPath& Path, float Distance)
+	{
+		const TArray<FNavPathPoint>& Points = Path.GetPathPoints();
+		for (int32 Index = 1; Index < Points.Num(); ++Index)
+		{
+			const float SegmentLength = FVector::Dist(Points[Index - 1].Location, Points[Index].Location);
+			if (Distance <= SegmentLength)
+			{
+				return FMath::Lerp(Points[Index - 1].Location, Points[Index].Location, SegmentLength > 0.f ? Distance / SegmentLength : 1.f);
+			}
+			Distance -= SegmentLength;
+		}
+		return Points.Last().Location;
+	}
+}
+
+bool UDGuardNavigationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UDGuardNavigationSubsystem::FPathCacheKey UDGuardNavigationSubsystem::MakeKey(const FVector& Start, const FVector& Goal) const
+{
+	const float CellSize = FMath::Max(DGuardNav::CellSize, 1.f);
+	// Floor, so cells either side of zero don't share index 0
+	auto ToCell = [CellSize](const FVector& Location)
+	{
+		return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+	};
+	return { ToCell(Start), ToCell(Goal) };
+}
+
+void UDGuardNavigationSubsystem::Deinitialize()
+{
+	// Nobody is left to hand the results to
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		for (const TPair<uint32, FPathCacheKey>& InFlight : InFlightQueries)
+		{
+			NavSys->AbortAsyncFindPathRequest(InFlight.Key);
+		}
+	}
+	InFlightQueries.Reset();
+
+	Super::Deinitialize();
+}
+
+uint32 UDGuardNavigationSubsystem::RequestPath(const FVector& Start, const FVector& Goal, FOnGuardPathReady OnReady)
+{
+	TotalRequests++;
+	INC_DWORD_STAT(STAT_DGuardNavRequests);
+
+	const FPathCacheKey Key = MakeKey(Start, Goal);
+	if (FNavPathSharedPtr CachedPath = FindCachedPath(Key))
+	{
+		TotalCacheHits++;
+		INC_DWORD_STAT(STAT_DGuardNavCacheHits);
+		OnReady.ExecuteIfBound(CachedPath);
+		return 0;
+	}
+
+	// Guards converging on the same spot share one query, queued or already running
+	FPendingQuery* Pending = PendingQueries.Find(Key);
+	if (Pending == nullptr)
+	{
+		Pending = &PendingQueries.Add(Key, { Start, Goal });
+		QueueOrder.Add(Key);
+		INC_DWORD_STAT(STAT_DGuardNavQueued);
+	}
+
+	const uint32 RequestId = NextRequestId++;
+	Pending->Waiting.Add({ RequestId, MoveTemp(OnReady) });
+	RequestKeys.Add(RequestId, Key);
+	return RequestId;
+}
+
+void UDGuardNavigationSubsystem::CancelRequest(uint32 RequestId)
+{
+	FPathCacheKey Key;
+	if (!RequestKeys.RemoveAndCopyValue(RequestId, Key)) { return; }
+
+	// The query stays queued or running even with nobody waiting, the path is still worth caching
+	if (FPendingQuery* Pending = PendingQueries.Find(Key))
+	{
+		Pending->Waiting.RemoveAll([RequestId](const FWaitingRequest& Waiting) { return Waiting.RequestId == RequestId; });
+	}
+}
+
+FNavPathSharedPtr UDGuardNavigationSubsystem::FindCachedPath(const FPathCacheKey& Key)
+{
+	FCachedPath* Cached = PathCache.Find(Key);
+	if (Cached == nullptr) { return nullptr; }
+
+	// The nav data marks paths crossing rebuilt tiles as out of date, only those are queried again
+	if (!Cached->Path.IsValid() || !Cached->Path->IsValid() || !Cached->Path->IsUpToDate())
+	{
+		PathCache.Remove(Key);
+		DEC_DWORD_STAT(STAT_DGuardNavCachedPaths);
+		return nullptr;
+	}
+
+	Cached->LastUsedTime = GetWorld()->GetTimeSeconds();
+	return Cached->Path;
+}
+
+void UDGuardNavigationSubsystem::AddCachedPath(const FPathCacheKey& Key, FNavPathSharedPtr Path)
+{
+	if (!PathCache.Contains(Key) && PathCache.Num() >= DGuardNav::MaxCachedPaths)
+	{
+		FPathCacheKey OldestKey;
+		double OldestTime = TNumericLimits<double>::Max();
+		for (const TPair<FPathCacheKey, FCachedPath>& Pair : PathCache)
+		{
+			if (Pair.Value.LastUsedTime < OldestTime)
+			{
+				OldestKey = Pair.Key;
+				OldestTime = Pair.Value.LastUsedTime;
+			}
+		}
+		PathCache.Remove(OldestKey);
+		DEC_DWORD_STAT(STAT_DGuardNavCachedPaths);
+	}
+
+	if (!PathCache.Contains(Key))
+	{
+		INC_DWORD_STAT(STAT_DGuardNavCachedPaths);
+	}
+	PathCache.Add(Key, { Path, GetWorld()->GetTimeSeconds() });
+}
+
+bool UDGuardNavigationSubsystem::SubmitQuery(const FPathCacheKey& Key)
+{
+	FPendingQuery* Pending = PendingQueries.Find(Key);
+	if (Pending == nullptr) { return false; }
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	if (NavData == nullptr)
+	{
+		CompleteQuery(Key, nullptr);
+		return false;
+	}
+
+	TotalQueries++;
+	INC_DWORD_STAT(STAT_DGuardNavQueries);
+	INC_DWORD_STAT(STAT_DGuardNavInFlight);
+
+	FPathFindingQuery Query(this, *NavData, Pending->Start, Pending->Goal);
+	Pending->QueryId = NavSys->FindPathAsync(FNavAgentProperties::DefaultProperties, Query,
+		FNavPathQueryDelegate::CreateUObject(this, &UDGuardNavigationSubsystem::OnQueryFinished));
+	InFlightQueries.Add(Pending->QueryId, Key);
+	return true;
+}
+
+void UDGuardNavigationSubsystem::OnQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FPathCacheKey Key;
+	if (!InFlightQueries.RemoveAndCopyValue(QueryId, Key)) { return; }
+	DEC_DWORD_STAT(STAT_DGuardNavInFlight);
+
+	if (Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		if (ANavigationData* NavData = Path->GetNavigationDataUsed())
+		{
+			NavData->RegisterActivePath(Path);
+		}
+		AddCachedPath(Key, Path);
+	}
+	else
+	{
+		Path = nullptr;
+	}
+
+	CompleteQuery(Key, Path);
+}
+
+void UDGuardNavigationSubsystem::CompleteQuery(const FPathCacheKey& Key, FNavPathSharedPtr Path)
+{
+	FPendingQuery Pending;
+	if (!PendingQueries.RemoveAndCopyValue(Key, Pending)) { return; }
+	DEC_DWORD_STAT(STAT_DGuardNavQueued);
+
+	for (FWaitingRequest& Waiting : Pending.Waiting)
+	{
+		RequestKeys.Remove(Waiting.RequestId);
+		Waiting.OnReady.ExecuteIfBound(Path);
+	}
+}
+
+void UDGuardNavigationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DGuardNavTick);
+
+	if (Benchmark.bRunning)
+	{
+		TickBenchmark();
+	}
+
+	// Oldest first, as many as the per frame and in flight limits allow. The searches run on the navigation system's worker
+	int32 NumTaken = 0;
+	int32 NumSubmitted = 0;
+	while (NumTaken < QueueOrder.Num() && NumSubmitted < FMath::Max(DGuardNav::MaxSubmitsPerFrame, 1) && InFlightQueries.Num() < FMath::Max(DGuardNav::MaxQueriesInFlight, 1))
+	{
+		if (SubmitQuery(QueueOrder[NumTaken]))
+		{
+			NumSubmitted++;
+		}
+		NumTaken++;
+	}
+	QueueOrder.RemoveAt(0, NumTaken);
+}
+
+void UDGuardNavigationSubsystem::StartBenchmark(int32 NumGuards, float Duration)
+{
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys == nullptr)
+	{
+		UE_LOG(LogDishonored, Warning, TEXT("Guard navigation benchmark: no navigation system in this world"));
+		return;
+	}
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* Player = PlayerController ? PlayerController->GetPawn() : nullptr;
+	const FVector Origin = Player ? Player->GetActorLocation() : FVector::ZeroVector;
+
+	Benchmark = FBenchmark();
+	Benchmark.Target = Origin;
+	for (int32 Guard = 0; Guard < NumGuards; ++Guard)
+	{
+		FNavLocation Location;
+		if (NavSys->GetRandomReachablePointInRadius(Origin, 5000.f, Location))
+		{
+			Benchmark.GuardLocations.Add(Location.Location);
+		}
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	Benchmark.bRunning = Benchmark.GuardLocations.Num() > 0;
+	Benchmark.StartTime = Now;
+	Benchmark.EndTime = Now + Duration;
+	Benchmark.NextTargetMoveTime = Now + DGuardNav::BenchmarkTargetMoveInterval;
+	Benchmark.StartRequests = TotalRequests;
+	Benchmark.StartCacheHits = TotalCacheHits;
+	Benchmark.StartQueries = TotalQueries;
+
+	UE_LOG(LogDishonored, Display, TEXT("Guard navigation benchmark: %d guards for %.0f s"), Benchmark.GuardLocations.Num(), Duration);
+}
+
+void UDGuardNavigationSubsystem::TickBenchmark()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now >= Benchmark.EndTime)
+	{
+		const double Elapsed = Now - Benchmark.StartTime;
+		const int64 Requests = TotalRequests - Benchmark.StartRequests;
+		const int64 Hits = TotalCacheHits - Benchmark.StartCacheHits;
+		const int64 Queries = TotalQueries - Benchmark.StartQueries;
+		UE_LOG(LogDishonored, Display, TEXT("Guard navigation benchmark: %d guards, %lld requests (%.1f/s), %lld path queries (%.1f/s), cache hit rate %.1f%%, %d paths cached"),
+			Benchmark.GuardLocations.Num(), Requests, Requests / Elapsed, Queries, Queries / Elapsed, Requests > 0 ? 100.0 * Hits / Requests : 0.0, PathCache.Num());
+		Benchmark.bRunning = false;
+		return;
+	}
+
+	// Chase the player if there is one, otherwise a point that jumps around like a sprinting player
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (const APawn* Player = PlayerController ? PlayerController->GetPawn() : nullptr)
+	{
+		Benchmark.Target = Player->GetActorLocation();
+	}
+	else if (Now >= Benchmark.NextTargetMoveTime)
+	{
+		Benchmark.NextTargetMoveTime = Now + DGuardNav::BenchmarkTargetMoveInterval;
+		FNavLocation Location;
+		if (const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			if (NavSys->GetRandomReachablePointInRadius(Benchmark.Target, 1500.f, Location))
+			{
+				Benchmark.Target = Location.Location;
+			}
+		}
+	}
+
+	if (Now < Benchmark.NextRepathTime) { return; }
+	Benchmark.NextRepathTime = Now + DGuardNav::BenchmarkRepathInterval;
+
+	// Every guard repaths, moving along whatever it gets back
+	for (int32 Guard = 0; Guard < Benchmark.GuardLocations.Num(); ++Guard)
+	{
+		RequestPath(Benchmark.GuardLocations[Guard], Benchmark.Target, FOnGuardPathReady::CreateWeakLambda(this, [this, Guard](FNavPathSharedPtr Path)
+		{
+			if (Path.IsValid() && Path->GetPathPoints().Num() > 0 && Benchmark.GuardLocations.IsValidIndex(Guard))
+			{
+				Benchmark.GuardLocations[Guard] = DGuardNav::AdvanceAlongPath(*Path, DGuardNav::BenchmarkGuardSpeed * DGuardNav::BenchmarkRepathInterval);
+			}
+		}));
+	}
+}
+
+TStatId UDGuardNavigationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDGuardNavigationSubsystem, STATGROUP_Tickables);
+}
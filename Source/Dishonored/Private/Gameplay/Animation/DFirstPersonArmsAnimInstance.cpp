@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Animation/DFirstPersonArmsAnimInstance.h"
+#include "Dishonored.h"
+
+DECLARE_CYCLE_STAT(TEXT("Arms Anim Update (worker)"), STAT_DArmsWorkerUpdate, STATGROUP_Dishonored);
+DECLARE_CYCLE_STAT(TEXT("Arms Anim Evaluate (worker)"), STAT_DArmsWorkerEvaluate, STATGROUP_Dishonored);
+
+void FDFirstPersonArmsAnimInstanceProxy::UpdateAnimationNode(const FAnimationUpdateContext& InContext)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DArmsWorkerUpdate);
+	FAnimInstanceProxy::UpdateAnimationNode(InContext);
+}
+
+bool FDFirstPersonArmsAnimInstanceProxy::Evaluate(FPoseContext& Output)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DArmsWorkerEvaluate);
+	EvaluateAnimationNode(Output);
+	return true;
+}
+
+UDFirstPersonArmsAnimInstance::UDFirstPersonArmsAnimInstance()
+{
+	bUseMultiThreadedAnimationUpdate = true;
+}
+
+FAnimInstanceProxy* UDFirstPersonArmsAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FDFirstPersonArmsAnimInstanceProxy(this);
+}
+
+void UDFirstPersonArmsAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	delete static_cast<FDFirstPersonArmsAnimInstanceProxy*>(InProxy);
+}
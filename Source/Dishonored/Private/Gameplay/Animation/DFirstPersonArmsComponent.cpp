@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Animation/DFirstPersonArmsComponent.h"
+#include "Dishonored.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Arms Anim Game Thread"), STAT_DArmsGameThread, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Arms Anim Ticks"), STAT_DArmsTicks, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Arms Anim Poses Held"), STAT_DArmsPosesHeld, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Arms Montages Coalesced"), STAT_DArmsMontagesCoalesced, STATGROUP_Dishonored);
+
+UDFirstPersonArmsComponent::UDFirstPersonArmsComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	// Arms fill a good part of the screen, skipping frames with update rate optimizations shows
+	bEnableUpdateRateOptimizations = false;
+
+	// Nothing to animate when nobody sees them (headless bots, dedicated servers)
+	VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+}
+
+void UDFirstPersonArmsComponent::PlayMontageCoalesced(UAnimMontage* Montage, float PlayRate)
+{
+	UAnimInstance* AnimInstance = GetAnimInstance();
+	if (Montage == nullptr || AnimInstance == nullptr) { return; }
+
+	// A montage stops counting as playing once it starts blending out, that is when the next one can start
+	if (AnimInstance->Montage_IsPlaying(Montage))
+	{
+		INC_DWORD_STAT(STAT_DArmsMontagesCoalesced);
+		return;
+	}
+
+	// Start animating again this frame rather than when the next tick notices the montage
+	StaticTime = 0.f;
+	bPoseHeld = false;
+	AnimInstance->Montage_Play(Montage, PlayRate);
+}
+
+void UDFirstPersonArmsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	// Give blends out of movement and montages time to settle before holding the pose
+	const UAnimInstance* AnimInstance = GetAnimInstance();
+	const bool bStill = AnimInstance != nullptr && !AnimInstance->IsAnyMontagePlaying()
+		&& GetOwner()->GetVelocity().SizeSquared() <= FMath::Square(StaticSpeedTolerance);
+	StaticTime = bStill ? StaticTime + DeltaTime : 0.f;
+	bPoseHeld = StaticTime >= StaticSettleTime;
+
+	if (bPoseHeld)
+	{
+		INC_DWORD_STAT(STAT_DArmsPosesHeld);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DArmsGameThread);
+	INC_DWORD_STAT(STAT_DArmsTicks);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
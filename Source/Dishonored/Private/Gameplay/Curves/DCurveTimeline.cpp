@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Curves/DCurveTimeline.h"
+#include "Curves/CurveFloat.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace DBakedCurveCache
+{
+	TMap<TObjectKey<UCurveFloat>, TSharedRef<const FDBakedCurve>> Tables;
+
+#if WITH_EDITOR
+	FDelegateHandle ObjectModifiedHandle;
+
+	/** Drops the table for a curve that is being edited so the next request rebakes it */
+	void OnObjectModified(UObject* Object)
+	{
+		if (const UCurveFloat* Curve = Cast<UCurveFloat>(Object))
+		{
+			Tables.Remove(Curve);
+		}
+	}
+#endif
+
+	TSharedRef<const FDBakedCurve> Bake(const UCurveFloat* Curve)
+	{
+		TSharedRef<FDBakedCurve> Baked = MakeShared<FDBakedCurve>();
+		Curve->GetTimeRange(Baked->MinTime, Baked->MaxTime);
+
+		const float Range = Baked->MaxTime - Baked->MinTime;
+		const int32 NumSamples = FMath::Max(2, FMath::CeilToInt(Range * FDBakedCurve::SamplesPerSecond) + 1);
+		Baked->SamplesPerTime = Range > UE_SMALL_NUMBER ? (NumSamples - 1) / Range : 0.f;
+
+		Baked->Samples.SetNumUninitialized(NumSamples);
+		for (int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			const float Time = Baked->MinTime + Range * Index / (NumSamples - 1);
+			Baked->Samples[Index] = Curve->GetFloatValue(Time);
+		}
+
+		return Baked;
+	}
+}
+
+float FDBakedCurve::Evaluate(float Time) const
+{
+	if (Samples.Num() == 0) { return 0.f; }
+
+	const float SampleTime = FMath::Clamp(Time - MinTime, 0.f, MaxTime - MinTime) * SamplesPerTime;
+	const int32 Index = FMath::Min(FMath::FloorToInt(SampleTime), Samples.Num() - 2);
+	return FMath::Lerp(Samples[Index], Samples[Index + 1], SampleTime - Index);
+}
+
+TSharedRef<const FDBakedCurve> FDBakedCurve::FindOrBake(const UCurveFloat* Curve)
+{
+	check(IsInGameThread());
+	check(Curve);
+
+#if WITH_EDITOR
+	if (!DBakedCurveCache::ObjectModifiedHandle.IsValid())
+	{
+		DBakedCurveCache::ObjectModifiedHandle = FCoreUObjectDelegates::OnObjectModified.AddStatic(&DBakedCurveCache::OnObjectModified);
+	}
+#endif
+
+	if (const TSharedRef<const FDBakedCurve>* Existing = DBakedCurveCache::Tables.Find(Curve))
+	{
+		return *Existing;
+	}
+
+	return DBakedCurveCache::Tables.Add(Curve, DBakedCurveCache::Bake(Curve));
+}
+
+void FDCurveTimeline::SetCurve(const UCurveFloat* Curve)
+{
+	BakedCurve = Curve ? FDBakedCurve::FindOrBake(Curve).ToSharedPtr() : nullptr;
+}
+
+void FDCurveTimeline::Play()
+{
+	bPlaying = true;
+	bReversing = false;
+}
+
+void FDCurveTimeline::PlayFromStart()
+{
+	Position = 0.f;
+	Play();
+}
+
+void FDCurveTimeline::Reverse()
+{
+	bPlaying = true;
+	bReversing = true;
+}
+
+void FDCurveTimeline::Stop()
+{
+	bPlaying = false;
+}
+
+void FDCurveTimeline::Tick(float DeltaTime)
+{
+	if (!bPlaying || !BakedCurve.IsValid()) { return; }
+
+	bool bFinished = false;
+
+	if (bReversing)
+	{
+		Position -= DeltaTime;
+		bFinished = Position <= 0.f;
+	}
+	else
+	{
+		Position += DeltaTime;
+		bFinished = Position >= Length;
+	}
+	Position = FMath::Clamp(Position, 0.f, Length);
+
+	OnUpdate.ExecuteIfBound(BakedCurve->Evaluate(Position));
+
+	if (bFinished)
+	{
+		bPlaying = false;
+		OnFinished.ExecuteIfBound();
+	}
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/LoadTest/DBotDriverComponent.h"
+#include "Gameplay/Player/DPlayerCharacter.h"
+#include "TP_WeaponComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "InputActionValue.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/CommandLine.h"
+
+namespace DBotDriver
+{
+	/** Finds the fire action of a weapon held by Character, if it has one */
+	const UInputAction* FindFireAction(const ADPlayerCharacter* Character)
+	{
+		// AttachWeapon adds the weapon to its holder's instance components
+		UTP_WeaponComponent* Weapon = nullptr;
+		return Character->GetInstanceComponents().FindItemByClass(&Weapon) ? Weapon->FireAction : nullptr;
+	}
+}
+
+UDBotDriverComponent::UDBotDriverComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	Phase = EPhase::Walk;
+	PhaseTimeLeft = 0.f;
+	TurnDirection = 1.f;
+	bCrouchToggled = false;
+}
+
+bool UDBotDriverComponent::IsBotClient()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("DBot"));
+}
+
+void UDBotDriverComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Every bot runs in its own process, seed from that so they don't all move in lockstep
+	Random.Initialize(FPlatformProcess::GetCurrentProcessId());
+	TurnDirection = Random.FRand() < 0.5f ? -1.f : 1.f;
+	Phase = static_cast<EPhase>(Random.RandHelper(static_cast<int32>(EPhase::Num)));
+	PhaseTimeLeft = Random.FRandRange(PhaseDuration.X, PhaseDuration.Y);
+}
+
+void UDBotDriverComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	APlayerController* PlayerController = GetOwner<APlayerController>();
+	ADPlayerCharacter* Character = PlayerController ? Cast<ADPlayerCharacter>(PlayerController->GetPawn()) : nullptr;
+	UEnhancedInputLocalPlayerSubsystem* Input = PlayerController ? ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()) : nullptr;
+	if (Character == nullptr || Input == nullptr) { return; }
+
+	PhaseTimeLeft -= DeltaTime;
+	if (PhaseTimeLeft <= 0.f)
+	{
+		EPhase NextPhase = static_cast<EPhase>((static_cast<int32>(Phase) + 1) % static_cast<int32>(EPhase::Num));
+
+		// Bots only have a weapon once they have walked over a pickup, until then there is nothing to fire
+		if (NextPhase == EPhase::Fire && DBotDriver::FindFireAction(Character) == nullptr)
+		{
+			NextPhase = EPhase::Walk;
+		}
+		EnterPhase(NextPhase, Character, Input);
+	}
+
+	// Always moving and turning, weaving a little from side to side
+	const float Strafe = FMath::Sin(GetWorld()->GetTimeSeconds()) * 0.5f;
+	Input->InjectInputForAction(Character->GetMoveAction(), FInputActionValue(FVector2D(Strafe, 1.f)));
+	Input->InjectInputForAction(Character->GetLookAction(), FInputActionValue(FVector2D(TurnInput * TurnDirection, 0.f)));
+
+	// Held actions have to be injected every frame, they complete on the first frame without one
+	if (Phase == EPhase::Sprint || Phase == EPhase::Slide)
+	{
+		Input->InjectInputForAction(Character->GetSprintAction(), FInputActionValue(true));
+	}
+	else if (Phase == EPhase::Fire)
+	{
+		if (const UInputAction* FireAction = DBotDriver::FindFireAction(Character))
+		{
+			Input->InjectInputForAction(FireAction, FInputActionValue(true));
+		}
+	}
+}
+
+void UDBotDriverComponent::EnterPhase(EPhase NewPhase, ADPlayerCharacter* Character, UEnhancedInputLocalPlayerSubsystem* Input)
+{
+	// Crouch toggles, so stand back up before doing anything else
+	if (bCrouchToggled)
+	{
+		Input->InjectInputForAction(Character->GetCrouchAction(), FInputActionValue(true));
+		bCrouchToggled = false;
+	}
+
+	// Crouching while still sprinting from the previous phase starts a slide
+	if (NewPhase == EPhase::Slide || NewPhase == EPhase::Crouch)
+	{
+		Input->InjectInputForAction(Character->GetCrouchAction(), FInputActionValue(true));
+		bCrouchToggled = NewPhase == EPhase::Crouch;
+	}
+
+	Phase = NewPhase;
+	PhaseTimeLeft = Random.FRandRange(PhaseDuration.X, PhaseDuration.Y);
+}
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/LoadTest/DServerLoadSubsystem.h"
+#include "Dishonored.h"
+#include "Gameplay/Networking/DReplicationGraph.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/CoreDelegates.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Server Load Connections"), STAT_DServerLoadConnections, STATGROUP_Dishonored);
+
+namespace DServerLoad
+{
+	/** Projectile counts are grouped in steps of this many so the curve stays readable */
+	constexpr int32 ProjectileBucketSize = 25;
+
+	static float ReportInterval = 10.f;
+	static FAutoConsoleVariableRef CVarReportInterval(
+		TEXT("d.Load.ReportInterval"),
+		ReportInterval,
+		TEXT("Seconds between periodic server load log lines, 0 to only report on d.Load.Report"));
+
+	static FAutoConsoleCommandWithWorld ReportCommand(
+		TEXT("d.Load.Report"),
+		TEXT("Logs average server tick time, replication time, CPU and bandwidth per connection for every player and projectile count seen"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UDServerLoadSubsystem* ServerLoad = World ? World->GetSubsystem<UDServerLoadSubsystem>() : nullptr)
+			{
+				ServerLoad->ReportCurve();
+			}
+		}));
+
+	static FAutoConsoleCommandWithWorld ResetCommand(
+		TEXT("d.Load.Reset"),
+		TEXT("Forgets all recorded server load samples"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (UDServerLoadSubsystem* ServerLoad = World ? World->GetSubsystem<UDServerLoadSubsystem>() : nullptr)
+			{
+				ServerLoad->ResetSamples();
+			}
+		}));
+}
+
+bool UDServerLoadSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDServerLoadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UDServerLoadSubsystem::OnWorldTickStart);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &UDServerLoadSubsystem::OnEndFrame);
+}
+
+void UDServerLoadSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+
+	if (SamplesByPlayers.Num() > 0)
+	{
+		ReportCurve();
+	}
+
+	Super::Deinitialize();
+}
+
+void UDServerLoadSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+	if (World == GetWorld())
+	{
+		TickStartCycles = FPlatformTime::Cycles64();
+	}
+}
+
+void UDServerLoadSubsystem::OnEndFrame()
+{
+	// Only servers have anything to measure
+	const UWorld* World = GetWorld();
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	if (NetDriver == nullptr || !NetDriver->IsServer() || TickStartCycles == 0) { return; }
+
+	const double TickMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - TickStartCycles);
+	TickStartCycles = 0;
+
+	const int32 NumConnections = NetDriver->ClientConnections.Num();
+	double OutBytes = 0.0;
+	double InBytes = 0.0;
+	for (const UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		OutBytes += Connection->OutBytesPerSecond;
+		InBytes += Connection->InBytesPerSecond;
+	}
+	SET_DWORD_STAT(STAT_DServerLoadConnections, NumConnections);
+
+	// Replication time and projectile count are only known when the replication graph is in use
+	const UDReplicationGraph* ReplicationGraph = Cast<UDReplicationGraph>(NetDriver->GetReplicationDriver());
+	const double ReplicationMs = ReplicationGraph ? ReplicationGraph->GetLastReplicationMs() : 0.0;
+	const int32 NumProjectiles = ReplicationGraph ? ReplicationGraph->GetNumProjectiles() : 0;
+	const int32 ProjectileBucket = NumProjectiles / DServerLoad::ProjectileBucketSize * DServerLoad::ProjectileBucketSize;
+
+	FLoadSamples& Samples = SamplesByPlayers.FindOrAdd(NumConnections).FindOrAdd(ProjectileBucket);
+	Samples.Frames++;
+	Samples.TickMsSum += TickMs;
+	Samples.TickMsMax = FMath::Max(Samples.TickMsMax, TickMs);
+	Samples.ReplicationMsSum += ReplicationMs;
+	Samples.CPUPctSum += FPlatformTime::GetCPUTime().CPUTimePct;
+	if (NumConnections > 0)
+	{
+		Samples.OutBytesPerConnectionSum += OutBytes / NumConnections;
+		Samples.InBytesPerConnectionSum += InBytes / NumConnections;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (DServerLoad::ReportInterval > 0.f && Now >= NextPeriodicReportTime)
+	{
+		NextPeriodicReportTime = Now + DServerLoad::ReportInterval;
+		UE_LOG(LogDishonored, Display, TEXT("Server load: %d players, %d projectiles, tick %.2f ms, replication %.2f ms, out %.0f B/s, in %.0f B/s per connection"),
+			NumConnections, NumProjectiles, TickMs, ReplicationMs, NumConnections > 0 ? OutBytes / NumConnections : 0.0, NumConnections > 0 ? InBytes / NumConnections : 0.0);
+	}
+}
+
+void UDServerLoadSubsystem::ReportCurve() const
+{
+	UE_LOG(LogDishonored, Display, TEXT("Server load curve: Players, Projectiles, Frames, AvgTickMs, MaxTickMs, AvgReplicationMs, AvgCPUPct, OutBytesPerSecPerConnection, InBytesPerSecPerConnection"));
+	for (const TPair<int32, TSortedMap<int32, FLoadSamples>>& PlayersPair : SamplesByPlayers)
+	{
+		for (const TPair<int32, FLoadSamples>& ProjectilesPair : PlayersPair.Value)
+		{
+			const FLoadSamples& Samples = ProjectilesPair.Value;
+			UE_LOG(LogDishonored, Display, TEXT("Server load curve: %d, %d, %d, %.3f, %.3f, %.3f, %.1f, %.0f, %.0f"),
+				PlayersPair.Key, ProjectilesPair.Key, Samples.Frames, Samples.TickMsSum / Samples.Frames, Samples.TickMsMax,
+				Samples.ReplicationMsSum / Samples.Frames, Samples.CPUPctSum / Samples.Frames,
+				Samples.OutBytesPerConnectionSum / Samples.Frames, Samples.InBytesPerConnectionSum / Samples.Frames);
+		}
+	}
+}
+
+void UDServerLoadSubsystem::ResetSamples()
+{
+	SamplesByPlayers.Reset();
+}
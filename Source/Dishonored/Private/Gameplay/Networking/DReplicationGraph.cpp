@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Networking/DReplicationGraph.h"
+#include "Dishonored.h"
+#include "DishonoredProjectile.h"
+#include "TP_PickUpComponent.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformTime.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Replication Graph Replicate Actors"), STAT_DReplicationGraphReplicate, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Replication Graph Projectiles"), STAT_DReplicationGraphProjectiles, STATGROUP_Dishonored);
+
+void UDReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// Pawns change with possession and death, so rebuild the list every time
+	ReplicationActorList.Reset();
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		if (APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+		{
+			ReplicationActorList.ConditionalAdd(PlayerController);
+			if (APawn* Pawn = PlayerController->GetPawn())
+			{
+				ReplicationActorList.ConditionalAdd(Pawn);
+			}
+		}
+
+		if (Viewer.ViewTarget != nullptr)
+		{
+			ReplicationActorList.ConditionalAdd(Viewer.ViewTarget);
+		}
+	}
+
+	Super::GatherActorListsForConnection(Params);
+}
+
+void UDReplicationGraph::ResetGameWorldState()
+{
+	Super::ResetGameWorldState();
+
+	NumProjectiles = 0;
+	SET_DWORD_STAT(STAT_DReplicationGraphProjectiles, 0);
+}
+
+void UDReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated()) { continue; }
+
+		// Leftovers from Blueprint compilation never spawn
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_"))) { continue; }
+
+		FClassReplicationInfo ClassInfo;
+		if (Class->IsChildOf<ADishonoredProjectile>())
+		{
+			// Shots are fast and short lived, send them every frame but only to players close enough to see them
+			ClassInfo.ReplicationPeriodFrame = 1;
+			ClassInfo.SetCullDistanceSquared(FMath::Square(ProjectileCullDistance));
+		}
+		else
+		{
+			ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+			if (!ActorCDO->bAlwaysRelevant && !ActorCDO->bOnlyRelevantToOwner)
+			{
+				ClassInfo.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+			}
+		}
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UDReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UDReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UDReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnection = CreateNewNode<UDReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnection, RepGraphConnection);
+}
+
+EDClassRepNodeMapping UDReplicationGraph::GetMappingPolicy(const AActor* Actor)
+{
+	if (const EDClassRepNodeMapping* Policy = ClassPolicies.Find(Actor->GetClass()))
+	{
+		return *Policy;
+	}
+
+	EDClassRepNodeMapping Policy;
+	if (Actor->IsA<ADishonoredProjectile>() || Actor->IsA<APawn>())
+	{
+		Policy = EDClassRepNodeMapping::Spatialize_Dynamic;
+	}
+	else if (Actor->FindComponentByClass<UTP_PickUpComponent>() != nullptr)
+	{
+		Policy = EDClassRepNodeMapping::Spatialize_Dormancy;
+	}
+	else if (Actor->bAlwaysRelevant || Actor->IsA<AInfo>())
+	{
+		Policy = EDClassRepNodeMapping::RelevantAllConnections;
+	}
+	else if (Actor->bOnlyRelevantToOwner)
+	{
+		Policy = EDClassRepNodeMapping::NotRouted;
+	}
+	else
+	{
+		const USceneComponent* Root = Actor->GetRootComponent();
+		const bool bMovable = Root != nullptr && Root->Mobility == EComponentMobility::Movable;
+		Policy = bMovable ? EDClassRepNodeMapping::Spatialize_Dynamic : EDClassRepNodeMapping::Spatialize_Static;
+	}
+
+	ClassPolicies.Add(Actor->GetClass(), Policy);
+	return Policy;
+}
+
+void UDReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Actor))
+	{
+	case EDClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EDClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EDClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EDClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+
+	if (ActorInfo.Actor->IsA<ADishonoredProjectile>())
+	{
+		NumProjectiles++;
+		INC_DWORD_STAT(STAT_DReplicationGraphProjectiles);
+	}
+}
+
+void UDReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Actor))
+	{
+	case EDClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EDClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EDClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EDClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+
+	if (ActorInfo.Actor->IsA<ADishonoredProjectile>())
+	{
+		NumProjectiles--;
+		DEC_DWORD_STAT(STAT_DReplicationGraphProjectiles);
+	}
+}
+
+int32 UDReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DReplicationGraphReplicate);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+	LastReplicationMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	return Result;
+}
@@ -0,0 +1,453 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Player/DCharacterMovementComponent.h"
+#include "Dishonored.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Controller.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeExit.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mantle Probes"), STAT_DMantleProbes, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mantle Probe Traces"), STAT_DMantleProbeTraces, STATGROUP_Dishonored);
+
+namespace DMantleStats
+{
+	int32 Attempts = 0;
+	int32 Successes = 0;
+	int64 Traces = 0;
+	double StartTime = FPlatformTime::Seconds();
+
+	void AddTraces(int32 Count)
+	{
+		Traces += Count;
+		INC_DWORD_STAT_BY(STAT_DMantleProbeTraces, Count);
+	}
+
+	void LogReport()
+	{
+		const double Elapsed = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+		const float SuccessRate = Attempts > 0 ? 100.f * Successes / Attempts : 0.f;
+		UE_LOG(LogDishonored, Display, TEXT("Mantle: %d/%d succeeded (%.1f%%), %lld probe traces in %.2fs (%.1f traces/s)"),
+			Successes, Attempts, SuccessRate, Traces, Elapsed, Traces / Elapsed);
+	}
+
+	static FAutoConsoleCommand ReportCommand(
+		TEXT("d.Mantle.Report"),
+		TEXT("Logs the mantle success rate and ledge probe traces per second since the last reset"),
+		FConsoleCommandDelegate::CreateStatic(&LogReport));
+
+	void ResetStats()
+	{
+		Attempts = 0;
+		Successes = 0;
+		Traces = 0;
+		StartTime = FPlatformTime::Seconds();
+	}
+
+	static FAutoConsoleCommand ResetCommand(
+		TEXT("d.Mantle.ResetStats"),
+		TEXT("Resets the counters reported by d.Mantle.Report"),
+		FConsoleCommandDelegate::CreateStatic(&ResetStats));
+
+	/** Scripted player for d.Mantle.Drive, so the mantle stats can be gathered headless */
+	struct FCourseDriver
+	{
+		TWeakObjectPtr<UWorld> World;
+		FTSTicker::FDelegateHandle TickerHandle;
+		double EndTime = 0.0;
+		double NextJumpTime = 0.0;
+		/** How long each character has been stood still */
+		TMap<TWeakObjectPtr<ACharacter>, float> StuckTimes;
+		FRandomStream Random;
+	};
+	static FCourseDriver CourseDriver;
+
+	/** How often the driver presses jump */
+	constexpr float CourseJumpInterval = 0.75f;
+	/** How long the driver can stand still against something it can't climb before turning away */
+	constexpr float CourseStuckTime = 1.5f;
+
+	bool TickCourseDriver(float DeltaTime)
+	{
+		UWorld* World = CourseDriver.World.Get();
+		const double Now = FPlatformTime::Seconds();
+		if (World == nullptr || Now >= CourseDriver.EndTime)
+		{
+			LogReport();
+			CourseDriver.StuckTimes.Reset();
+			CourseDriver.TickerHandle.Reset();
+			return false;
+		}
+
+		// Run every character with our movement forward, jumping (or mantling, like the jump key) every so often
+		const bool bJump = Now >= CourseDriver.NextJumpTime;
+		if (bJump)
+		{
+			CourseDriver.NextJumpTime = Now + CourseJumpInterval;
+		}
+
+		for (TObjectIterator<UDCharacterMovementComponent> It; It; ++It)
+		{
+			ACharacter* Character = It->GetCharacterOwner();
+			AController* Controller = Character ? Character->GetController() : nullptr;
+			if (It->GetWorld() != World || Controller == nullptr) { continue; }
+
+			Character->AddMovementInput(Character->GetActorForwardVector());
+
+			if (bJump && !It->IsMantling() && !It->TryMantle())
+			{
+				Character->Jump();
+			}
+
+			// Turn somewhere else when we have been pressed against the same wall for a while
+			float& StuckTime = CourseDriver.StuckTimes.FindOrAdd(Character);
+			StuckTime = It->Velocity.SizeSquared2D() < 100.f ? StuckTime + DeltaTime : 0.f;
+			if (StuckTime >= CourseStuckTime)
+			{
+				StuckTime = 0.f;
+				FRotator Rotation = Controller->GetControlRotation();
+				Rotation.Yaw += CourseDriver.Random.FRandRange(90.f, 270.f);
+				Controller->SetControlRotation(Rotation);
+			}
+		}
+		return true;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs DriveCommand(
+		TEXT("d.Mantle.Drive"),
+		TEXT("d.Mantle.Drive [Seconds=30]: runs the player around jumping into whatever is in front of it, then logs d.Mantle.Report. Works headless"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (World == nullptr) { return; }
+
+			FTSTicker::GetCoreTicker().RemoveTicker(CourseDriver.TickerHandle);
+			ResetStats();
+
+			const float Duration = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 30.f;
+			CourseDriver.World = World;
+			CourseDriver.EndTime = FPlatformTime::Seconds() + FMath::Max(Duration, 1.f);
+			CourseDriver.NextJumpTime = 0.0;
+			CourseDriver.StuckTimes.Reset();
+			CourseDriver.Random.Initialize(0);
+			CourseDriver.TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickCourseDriver));
+		}));
+}
+
+/** Saved move carrying the mantle request, so the server replays it with the move that asked for it */
+class FSavedMove_DCharacter : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override
+	{
+		Super::Clear();
+		bSavedWantsToMantle = false;
+	}
+
+	virtual uint8 GetCompressedFlags() const override
+	{
+		uint8 Flags = Super::GetCompressedFlags();
+		if (bSavedWantsToMantle)
+		{
+			Flags |= FLAG_Custom_0;
+		}
+		return Flags;
+	}
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override
+	{
+		// Never fold the mantle request into another move
+		if (bSavedWantsToMantle != static_cast<const FSavedMove_DCharacter*>(NewMove.Get())->bSavedWantsToMantle) { return false; }
+		return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+	}
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override
+	{
+		Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+		if (const UDCharacterMovementComponent* Movement = Cast<UDCharacterMovementComponent>(C->GetCharacterMovement()))
+		{
+			bSavedWantsToMantle = Movement->bWantsToMantle;
+		}
+	}
+
+	virtual void PrepMoveFor(ACharacter* C) override
+	{
+		Super::PrepMoveFor(C);
+		if (UDCharacterMovementComponent* Movement = Cast<UDCharacterMovementComponent>(C->GetCharacterMovement()))
+		{
+			Movement->bWantsToMantle = bSavedWantsToMantle;
+		}
+	}
+
+	bool bSavedWantsToMantle = false;
+};
+
+class FNetworkPredictionData_Client_DCharacter : public FNetworkPredictionData_Client_Character
+{
+public:
+	FNetworkPredictionData_Client_DCharacter(const UCharacterMovementComponent& ClientMovement)
+		: FNetworkPredictionData_Client_Character(ClientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override
+	{
+		return FSavedMovePtr(new FSavedMove_DCharacter());
+	}
+};
+
+UDCharacterMovementComponent::UDCharacterMovementComponent()
+{
+	MantleStart = FVector::ZeroVector;
+	MantleTarget = FVector::ZeroVector;
+	MantleElapsed = 0.f;
+	bWantsToMantle = false;
+}
+
+FNetworkPredictionData_Client* UDCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UDCharacterMovementComponent* MutableThis = const_cast<UDCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_DCharacter(*this);
+	}
+	return ClientPredictionData;
+}
+
+void UDCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToMantle = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+void UDCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	// Client and server both start the mantle here, from the same move, with their own ledge probes
+	if (bWantsToMantle)
+	{
+		bWantsToMantle = false;
+		if (!IsMantling() && HasMantleLedge())
+		{
+			StartMantle();
+		}
+	}
+}
+
+bool UDCharacterMovementComponent::TryMantle()
+{
+	if (IsMantling() || !CanProbeForLedge()) { return false; }
+
+	const bool bHasLedge = HasMantleLedge();
+
+	// Jumping with nothing in front of us was never a mantle, only count jumps into a wall
+	if (LedgeProbeCache.bHitWall)
+	{
+		DMantleStats::Attempts++;
+	}
+
+	if (!bHasLedge) { return false; }
+
+	DMantleStats::Successes++;
+
+	bWantsToMantle = true;
+	return true;
+}
+
+void UDCharacterMovementComponent::StartMantle()
+{
+	MantleStart = UpdatedComponent->GetComponentLocation();
+	MantleTarget = LedgeProbeCache.MantleTarget;
+	SetMovementMode(MOVE_Custom, CMOVE_DMantle);
+}
+
+bool UDCharacterMovementComponent::CanProbeForLedge() const
+{
+	if (!CharacterOwner || !UpdatedComponent || IsCrouching()) { return false; }
+
+	// Only mantle from the ground or while in the air
+	return IsMovingOnGround() || IsFalling();
+}
+
+bool UDCharacterMovementComponent::HasMantleLedge()
+{
+	if (!CanProbeForLedge()) { return false; }
+
+	if (ShouldReissueLedgeProbes())
+	{
+		IssueLedgeProbes();
+	}
+
+	return LedgeProbeCache.bHasLedge;
+}
+
+bool UDCharacterMovementComponent::IsMantling() const
+{
+	return MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_DMantle;
+}
+
+bool UDCharacterMovementComponent::ShouldReissueLedgeProbes() const
+{
+	if (!LedgeProbeCache.bValid) { return true; }
+
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	if (FVector::DistSquared(Location, LedgeProbeCache.ProbeLocation) > FMath::Square(MantleProbeReissueDistance)) { return true; }
+
+	const float Yaw = UpdatedComponent->GetComponentRotation().Yaw;
+	if (FMath::Abs(FRotator::NormalizeAxis(Yaw - LedgeProbeCache.ProbeYaw)) > MantleProbeReissueAngle) { return true; }
+
+	if (!FMath::IsNearlyEqual(CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), LedgeProbeCache.ProbeHalfHeight)) { return true; }
+
+	// A different floor means the ledge heights we measured against are no longer meaningful
+	const FHitResult& FloorHit = CurrentFloor.HitResult;
+	if (FloorHit.GetComponent() != LedgeProbeCache.FloorComponent.Get()) { return true; }
+	if ((FloorHit.ImpactNormal | LedgeProbeCache.FloorNormal) < 0.996f) { return true; }
+	if (FMath::Abs(FloorHit.ImpactPoint.Z - LedgeProbeCache.FloorZ) > MantleProbeReissueDistance) { return true; }
+
+	return false;
+}
+
+void UDCharacterMovementComponent::IssueLedgeProbes()
+{
+	SCOPE_CYCLE_COUNTER(STAT_DMantleProbes);
+
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const FQuat Rotation = UpdatedComponent->GetComponentQuat();
+	const float HalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const float Radius = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius();
+
+	LedgeProbeCache.bValid = true;
+	LedgeProbeCache.bHitWall = false;
+	LedgeProbeCache.bHasLedge = false;
+	LedgeProbeCache.ProbeLocation = Location;
+	LedgeProbeCache.ProbeYaw = UpdatedComponent->GetComponentRotation().Yaw;
+	LedgeProbeCache.ProbeHalfHeight = HalfHeight;
+	LedgeProbeCache.FloorComponent = CurrentFloor.HitResult.GetComponent();
+	LedgeProbeCache.FloorNormal = CurrentFloor.HitResult.ImpactNormal;
+	LedgeProbeCache.FloorZ = CurrentFloor.HitResult.ImpactPoint.Z;
+
+	const ECollisionChannel Channel = UpdatedComponent->GetCollisionObjectType();
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(DMantleProbe), false, CharacterOwner);
+	FCollisionResponseParams ResponseParams;
+	InitCollisionParams(Params, ResponseParams);
+	const FCollisionShape CapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_RadiusCustom, 2.f);
+
+	const FVector Forward = UpdatedComponent->GetForwardVector().GetSafeNormal2D();
+	const float FeetZ = Location.Z - HalfHeight;
+	int32 TraceCount = 0;
+
+	ON_SCOPE_EXIT
+	{
+		DMantleStats::AddTraces(TraceCount);
+	};
+
+	// Forward probe: is there a wall in front of us
+	FHitResult WallHit;
+	TraceCount++;
+	if (!GetWorld()->SweepSingleByChannel(WallHit, Location, Location + Forward * MantleReachDistance, Rotation, Channel, CapsuleShape, Params, ResponseParams)
+		|| WallHit.bStartPenetrating || IsWalkable(WallHit))
+	{
+		return;
+	}
+
+	LedgeProbeCache.bHitWall = true;
+
+	// Downward probe: is the top of that wall a walkable ledge within mantle range
+	const FVector WallNormal = WallHit.ImpactNormal.GetSafeNormal2D();
+	const FVector LedgeXY = WallHit.ImpactPoint - WallNormal * Radius;
+	const FVector LedgeTraceStart(LedgeXY.X, LedgeXY.Y, FeetZ + MantleMaxHeight + HalfHeight);
+	const FVector LedgeTraceEnd(LedgeXY.X, LedgeXY.Y, FeetZ + MantleMinHeight);
+
+	FHitResult LedgeHit;
+	TraceCount++;
+	if (!GetWorld()->LineTraceSingleByChannel(LedgeHit, LedgeTraceStart, LedgeTraceEnd, Channel, Params, ResponseParams)
+		|| LedgeHit.bStartPenetrating || !IsWalkable(LedgeHit)
+		|| LedgeHit.ImpactPoint.Z - FeetZ > MantleMaxHeight)
+	{
+		return;
+	}
+
+	// Clearance probes: room to rise up beside the wall, then to move onto the ledge
+	const FVector Target(LedgeXY.X, LedgeXY.Y, LedgeHit.ImpactPoint.Z + HalfHeight + MAX_FLOOR_DIST);
+	const FVector RiseTop(Location.X, Location.Y, Target.Z);
+
+	FHitResult ClearanceHit;
+	TraceCount++;
+	if (GetWorld()->SweepSingleByChannel(ClearanceHit, Location, RiseTop, Rotation, Channel, CapsuleShape, Params, ResponseParams))
+	{
+		return;
+	}
+
+	TraceCount++;
+	if (GetWorld()->SweepSingleByChannel(ClearanceHit, RiseTop, Target, Rotation, Channel, CapsuleShape, Params, ResponseParams))
+	{
+		return;
+	}
+
+	LedgeProbeCache.bHasLedge = true;
+	LedgeProbeCache.MantleTarget = Target;
+}
+
+void UDCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
+{
+	Super::PhysCustom(deltaTime, Iterations);
+
+	if (CustomMovementMode == CMOVE_DMantle)
+	{
+		PhysMantle(deltaTime, Iterations);
+	}
+}
+
+void UDCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	if (IsMantling())
+	{
+		MantleElapsed = 0.f;
+		Velocity = FVector::ZeroVector;
+	}
+	else if (PreviousMovementMode == MOVE_Custom && PreviousCustomMode == CMOVE_DMantle)
+	{
+		// We are somewhere new, the old probes no longer apply
+		LedgeProbeCache.bValid = false;
+	}
+}
+
+void UDCharacterMovementComponent::PhysMantle(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME) { return; }
+
+	MantleElapsed += deltaTime;
+	const float Alpha = FMath::Clamp(MantleElapsed / MantleDuration, 0.f, 1.f);
+
+	// Rise straight up alongside the wall, then move forward onto the ledge
+	const FVector RiseTop(MantleStart.X, MantleStart.Y, MantleTarget.Z);
+	const FVector Desired = Alpha < MantleRiseFraction
+		? FMath::Lerp(MantleStart, RiseTop, Alpha / MantleRiseFraction)
+		: FMath::Lerp(RiseTop, MantleTarget, (Alpha - MantleRiseFraction) / (1.f - MantleRiseFraction));
+
+	const FVector Delta = Desired - UpdatedComponent->GetComponentLocation();
+	Velocity = Delta / deltaTime;
+
+	FHitResult Hit(1.f);
+	SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+	if (Hit.IsValidBlockingHit())
+	{
+		SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
+	}
+
+	if (Alpha >= 1.f)
+	{
+		Velocity = FVector::ZeroVector;
+		SetMovementMode(MOVE_Walking);
+	}
+}
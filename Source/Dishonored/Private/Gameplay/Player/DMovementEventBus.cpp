@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Player/DMovementEventBus.h"
+#include "Dishonored.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Events Delivered"), STAT_DMovementEventsDelivered, STATGROUP_Dishonored);
+
+void UDMovementEventBus::QueueTransition(ADPlayerCharacter* Character, EMovementState PreviousState, EMovementState NewState)
+{
+	for (FPendingTransition& Pending : PendingTransitions)
+	{
+		if (Pending.Character.Get() == Character)
+		{
+			Pending.ToState = NewState;
+			return;
+		}
+	}
+
+	PendingTransitions.Add({ Character, PreviousState, NewState });
+}
+
+void UDMovementEventBus::Tick(float DeltaTime)
+{
+	// Listeners may queue new transitions, those go out next frame
+	TArray<FPendingTransition> Transitions = MoveTemp(PendingTransitions);
+	PendingTransitions.Reset();
+
+	for (const FPendingTransition& Transition : Transitions)
+	{
+		ADPlayerCharacter* Character = Transition.Character.Get();
+		if (Character == nullptr) { continue; }
+
+		// Crouch changes queue a transition to the same state, they only need the crouch flush
+		if (Transition.FromState != Transition.ToState)
+		{
+			OnMovementStateChanged.Broadcast(Character, Transition.FromState, Transition.ToState);
+			Character->NotifyMovementStateChanged(Transition.FromState, Transition.ToState);
+			INC_DWORD_STAT(STAT_DMovementEventsDelivered);
+		}
+		Character->NotifyCrouchChanged();
+	}
+}
+
+TStatId UDMovementEventBus::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDMovementEventBus, STATGROUP_Tickables);
+}
@@ -2,6 +2,13 @@
 
 
 #include "Gameplay/Player/DPlayerCharacter.h"
+#include "Gameplay/Player/DCharacterMovementComponent.h"
+#include "Gameplay/Player/DMovementEventBus.h"
+#include "Gameplay/Player/DPlayerController.h"
+#include "Gameplay/Animation/DFirstPersonArmsComponent.h"
+#include "Gameplay/Stealth/DLightExposureSubsystem.h"
+#include "Gameplay/Powers/DTimeControlSubsystem.h"
+#include "Gameplay/Startup/DStartupTimingSubsystem.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -10,11 +17,17 @@
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
 #include "Engine/LocalPlayer.h"
-#include "Components/TimelineComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "Camera/CameraTypes.h"
+#include "Engine/GameInstance.h"
+#include "Engine/InputDelegateBinding.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 // Sets default values
-ADPlayerCharacter::ADPlayerCharacter()
+ADPlayerCharacter::ADPlayerCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UDCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -29,7 +42,7 @@ ADPlayerCharacter::ADPlayerCharacter()
 	FirstPersonCameraComponent->bUsePawnControlRotation = true;
 
 	// Create a mesh component that will be used when being viewed from a '1st person' view (when controlling this pawn)
-	Mesh1P = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("CharacterMesh1P"));
+	Mesh1P = CreateDefaultSubobject<UDFirstPersonArmsComponent>(TEXT("CharacterMesh1P"));
 	Mesh1P->SetOnlyOwnerSee(true);
 	Mesh1P->SetupAttachment(FirstPersonCameraComponent);
 	Mesh1P->bCastDynamicShadow = false;
@@ -40,11 +53,22 @@ ADPlayerCharacter::ADPlayerCharacter()
 	bIsSprinting = false;
 	walkSpeed = 600;
 	sprintSpeed = 900;
+
+	LeanInput = 0.f;
+	LeanAlpha = 0.f;
+	SlideTiltRoll = 0.f;
+
+	bFixedStepSimulation = false;
+	FixedStepMovementInput = FVector::ZeroVector;
+	PresentationOffset = FVector::ZeroVector;
+	bNotifiedCrouched = false;
 }
 
 // Called when the game starts or when spawned
 void ADPlayerCharacter::BeginPlay()
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerCharacter::BeginPlay);
+
 	Super::BeginPlay();
 
 	UCharacterMovementComponent* CharacterMovementComp = GetCharacterMovement();
@@ -52,25 +76,49 @@ void ADPlayerCharacter::BeginPlay()
 	
 	if (CameraTiltCurve)
 	{
-		FOnTimelineFloat TimelineCallback;
-
-		TimelineCallback.BindUFunction(this, FName("TiltCamera"));
-		CameraTiltTimeline.AddInterpFloat(CameraTiltCurve, TimelineCallback);
+		TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerCharacter::BindCameraTiltTimeline);
+		CameraTiltTimeline.SetCurve(CameraTiltCurve);
+		CameraTiltTimeline.SetLength(TimelineLength);
+		CameraTiltTimeline.OnUpdate.BindUObject(this, &ADPlayerCharacter::TiltCamera);
 	}
 
 	StandingHalfHeight = GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
 	MovementState = EMovementState::Walk;
 	StandingZOffset = GetFirstPersonCameraComponent()->GetRelativeLocation().Z;
+	StandingYOffset = GetFirstPersonCameraComponent()->GetRelativeLocation().Y;
 
 	if (SlideCurve)
 	{
-		FOnTimelineFloat TimelineCallback;
-		FOnTimelineEventStatic TimelineFinishedCallback;
+		TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerCharacter::BindSlideTimeline);
+		SlideTimeline.SetCurve(SlideCurve);
+		SlideTimeline.SetLength(TimelineLength);
+		SlideTimeline.OnUpdate.BindUObject(this, &ADPlayerCharacter::SlidePlayer);
+		SlideTimeline.OnFinished.BindUObject(this, &ADPlayerCharacter::StopSliding);
+	}
 
-		TimelineCallback.BindUFunction(this, FName("SlidePlayer"));
-		TimelineFinishedCallback.BindUFunction(this, FName("StopSliding"));
-		SlideTimeline.AddInterpFloat(SlideCurve, TimelineCallback);
-		SlideTimeline.SetTimelineFinishedFunc(TimelineFinishedCallback);
+	if (UDLightExposureSubsystem* LightExposure = GetWorld()->GetSubsystem<UDLightExposureSubsystem>())
+	{
+		LightExposure->RegisterCharacter(this);
+	}
+
+	// In fixed step mode the subsystem drives our movement and slide instead of the frame delta
+	UDFixedStepSubsystem* FixedStepSubsystem = GetWorld()->GetSubsystem<UDFixedStepSubsystem>();
+	if (FixedStepSubsystem != nullptr && UDFixedStepSubsystem::IsFixedStepEnabled())
+	{
+		bFixedStepSimulation = true;
+		CharacterMovementComp->SetComponentTickEnabled(false);
+		FixedStepSubsystem->RegisterActor(this);
+	}
+
+	// Any of us can be possessed by a local player, have the bindings ready before that happens
+	if (CanBeLocallyPossessed())
+	{
+		PrebindInput();
+	}
+
+	if (UDStartupTimingSubsystem* StartupTiming = UGameInstance::GetSubsystem<UDStartupTimingSubsystem>(GetGameInstance()))
+	{
+		StartupTiming->MarkPhase(TEXT("CharacterBeginPlay"));
 	}
 }
 
@@ -79,8 +127,29 @@ void ADPlayerCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	CameraTiltTimeline.TickTimeline(DeltaTime);
-	SlideTimeline.TickTimeline(DeltaTime);
+	if (bFixedStepSimulation)
+	{
+		// Input arrives once per frame, every fixed step until the next frame moves with it
+		FixedStepMovementInput = ConsumeMovementInputVector();
+	}
+	else
+	{
+		CameraTiltTimeline.Tick(DeltaTime);
+		SlideTimeline.Tick(DeltaTime);
+	}
+
+	// Nothing to do unless we are leaning or settling back upright
+	if (LeanInput != 0.f || LeanAlpha != 0.f)
+	{
+		UpdateLean(DeltaTime);
+	}
+}
+
+void ADPlayerCharacter::CalcCamera(float DeltaTime, FMinimalViewInfo& OutResult)
+{
+	Super::CalcCamera(DeltaTime, OutResult);
+
+	OutResult.Location += PresentationOffset;
 }
 
 // Called to bind functionality to input
@@ -90,7 +159,7 @@ void ADPlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 	if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerInputComponent))
 	{
 		// Jumping
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &ACharacter::Jump);
+		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &ADPlayerCharacter::JumpOrMantle);
 		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Completed, this, &ACharacter::StopJumping);
 
 		// Moving
@@ -102,6 +171,14 @@ void ADPlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 		EnhancedInputComponent->BindAction(CrouchAction, ETriggerEvent::Started, this, &ADPlayerCharacter::DetermineCrouchOrSlide);
 		EnhancedInputComponent->BindAction(SprintAction, ETriggerEvent::Started, this, &ADPlayerCharacter::StartSprinting);
 		EnhancedInputComponent->BindAction(SprintAction, ETriggerEvent::Completed, this, &ADPlayerCharacter::StopSprinting);
+
+		// Leaning
+		EnhancedInputComponent->BindAction(LeanAction, ETriggerEvent::Triggered, this, &ADPlayerCharacter::Lean);
+		EnhancedInputComponent->BindAction(LeanAction, ETriggerEvent::Completed, this, &ADPlayerCharacter::StopLeaning);
+
+		// Powers
+		EnhancedInputComponent->BindAction(BendTimeAction, ETriggerEvent::Started, this, &ADPlayerCharacter::ToggleBendTime);
+		EnhancedInputComponent->BindAction(PossessAction, ETriggerEvent::Started, this, &ADPlayerCharacter::TryPossess);
 	}
 	else
 	{
@@ -110,6 +187,68 @@ void ADPlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 
 }
 
+void ADPlayerCharacter::DestroyPlayerInputComponent()
+{
+	// Our bindings only point at us and a controller only listens to the pawn it possesses,
+	// so keep them for the next possession instead of building them all again
+	if (IsActorBeingDestroyed())
+	{
+		Super::DestroyPlayerInputComponent();
+	}
+}
+
+void ADPlayerCharacter::OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
+{
+	Super::OnStartCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
+
+	// Crouching is independent of MovementState (we can sprint out of it), so queue a flush without changing state
+	if (UDMovementEventBus* MovementEventBus = GetWorld()->GetSubsystem<UDMovementEventBus>())
+	{
+		MovementEventBus->QueueTransition(this, MovementState, MovementState);
+	}
+}
+
+void ADPlayerCharacter::OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
+{
+	Super::OnEndCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
+
+	if (UDMovementEventBus* MovementEventBus = GetWorld()->GetSubsystem<UDMovementEventBus>())
+	{
+		MovementEventBus->QueueTransition(this, MovementState, MovementState);
+	}
+}
+
+bool ADPlayerCharacter::CanBeLocallyPossessed() const
+{
+	// Dedicated servers have nobody to bind input for, and on clients only the server swaps pawns,
+	// so only our own pawn or pawns a listen server or standalone host can take over qualify
+	if (GetNetMode() == NM_DedicatedServer) { return false; }
+	if (IsLocallyControlled()) { return true; }
+
+	const APlayerController* LocalController = GetWorld()->GetFirstPlayerController();
+	return HasAuthority() && LocalController != nullptr && LocalController->IsLocalController();
+}
+
+void ADPlayerCharacter::PrebindInput()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerCharacter::PrebindInput);
+
+	// Same as APawn::PawnClientRestart does on possession when there is no input component yet
+	if (InputComponent != nullptr) { return; }
+
+	InputComponent = CreatePlayerInputComponent();
+	if (InputComponent != nullptr)
+	{
+		SetupPlayerInputComponent(InputComponent);
+		InputComponent->RegisterComponent();
+		if (UInputDelegateBinding::SupportsInputDelegate(GetClass()))
+		{
+			InputComponent->bBlockInput = bBlockInput;
+			UInputDelegateBinding::BindInputDelegatesWithSubojects(this, InputComponent);
+		}
+	}
+}
+
 void ADPlayerCharacter::Move(const FInputActionValue& Value)
 {
 	// input is a Vector2D
@@ -136,10 +275,83 @@ void ADPlayerCharacter::Look(const FInputActionValue& Value)
 	}
 }
 
+void ADPlayerCharacter::JumpOrMantle()
+{
+	// Sliding commits us to the slide, everything else can try to climb first
+	if (MovementState != EMovementState::Slide && GetDCharacterMovement()->TryMantle())
+	{
+		return;
+	}
+
+	Jump();
+}
+
+void ADPlayerCharacter::Lean(const FInputActionValue& Value)
+{
+	LeanInput = FMath::Clamp(Value.Get<float>(), -1.f, 1.f);
+}
+
+void ADPlayerCharacter::StopLeaning()
+{
+	LeanInput = 0.f;
+}
+
+void ADPlayerCharacter::ToggleBendTime()
+{
+	UDTimeControlSubsystem* TimeControl = GetWorld()->GetSubsystem<UDTimeControlSubsystem>();
+	if (TimeControl == nullptr) { return; }
+
+	if (TimeControl->IsTimeStopped())
+	{
+		EndBendTime();
+		return;
+	}
+
+	TimeControl->StopTime(this);
+	GetWorldTimerManager().SetTimer(BendTimeTimerHandle, this, &ADPlayerCharacter::EndBendTime, BendTimeDuration);
+}
+
+void ADPlayerCharacter::EndBendTime()
+{
+	GetWorldTimerManager().ClearTimer(BendTimeTimerHandle);
+
+	if (UDTimeControlSubsystem* TimeControl = GetWorld()->GetSubsystem<UDTimeControlSubsystem>())
+	{
+		TimeControl->ResumeTime();
+	}
+}
+
+void ADPlayerCharacter::TryPossess()
+{
+	ADPlayerController* PlayerController = Cast<ADPlayerController>(Controller);
+	if (PlayerController == nullptr) { return; }
+
+	if (PlayerController->IsPossessing())
+	{
+		PlayerController->EndPossession();
+		return;
+	}
+
+	const FVector Start = GetFirstPersonCameraComponent()->GetComponentLocation();
+	const FVector End = Start + GetControlRotation().Vector() * PossessRange;
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(DPossessTrace), false, this);
+
+	FHitResult Hit;
+	if (GetWorld()->LineTraceSingleByChannel(Hit, Start, End, ECC_Pawn, QueryParams))
+	{
+		if (APawn* Target = Cast<APawn>(Hit.GetActor()))
+		{
+			PlayerController->BeginPossession(Target);
+		}
+	}
+}
+
 void ADPlayerCharacter::DetermineCrouchOrSlide()
 {
 	// Check if we are falling and if so do nothing
 	if (GetMovementComponent()->IsFalling()) { return;}
+	// The slide drives the capsule itself, crouching halfway through would fight it
+	if (MovementState == EMovementState::Slide) { return; }
 
 	// Check if we are sprinting to decide whether to crouch or not
 	if (MovementState != EMovementState::Sprint)
@@ -156,26 +368,27 @@ void ADPlayerCharacter::ToggleCrouch()
 {
 	if (!bIsCrouched)
 	{
-		MovementState = EMovementState::Crouch;
+		SetMovementState(EMovementState::Crouch);
 		Crouch();
-		OnCrouchChangedDelegate.Broadcast(true);
 	}
 	else
 	{
-		MovementState = EMovementState::Walk;
+		SetMovementState(EMovementState::Walk);
 		UnCrouch();
-		OnCrouchChangedDelegate.Broadcast(false);
 	}
 }
 
 void ADPlayerCharacter::StartSliding()
 {
+	SetMovementState(EMovementState::Slide);
 	CameraTiltTimeline.Play();
 	SlideTimeline.PlayFromStart();
 }
 
 void ADPlayerCharacter::StopSliding()
 {
+	// Come out of the slide in whatever state the capsule is actually in
+	SetMovementState(bIsCrouched ? EMovementState::Crouch : EMovementState::Walk);
 	CameraTiltTimeline.Reverse();
 	SlideTimeline.Stop();
 	GetCharacterMovement()->MaxWalkSpeed = walkSpeed;
@@ -183,33 +396,30 @@ void ADPlayerCharacter::StopSliding()
 
 void ADPlayerCharacter::StartSprinting()
 {
-	MovementState = EMovementState::Sprint;
+	SetMovementState(EMovementState::Sprint);
 	UCharacterMovementComponent* CharacterMovementComp = GetCharacterMovement();
 	CharacterMovementComp->MaxWalkSpeed = sprintSpeed;
 }
 
 void ADPlayerCharacter::StopSprinting()
 {
-	MovementState = EMovementState::Walk;
+	// Letting go of sprint mid slide doesn't end the slide, StopSliding picks the state to return to
+	if (MovementState != EMovementState::Slide)
+	{
+		SetMovementState(EMovementState::Walk);
+	}
 	UCharacterMovementComponent* CharacterMovementComp = GetCharacterMovement();
 	CharacterMovementComp->MaxWalkSpeed = walkSpeed;
 }
 
-void ADPlayerCharacter::TiltCamera()
+void ADPlayerCharacter::TiltCamera(float CurveFloatValue)
 {
-	float TimelineValue = CameraTiltTimeline.GetPlaybackPosition();
-	float CurveFloatValue = CameraTiltCurve->GetFloatValue(TimelineValue);
-
-	FRotator CurrentRotation = GetController()->GetControlRotation();
-	FRotator NewRotation = FRotator(CurrentRotation.Pitch, CurrentRotation.Yaw, CurveFloatValue);
-	GetController()->SetControlRotation(NewRotation);
+	SlideTiltRoll = CurveFloatValue;
+	ApplyCameraRoll();
 }
 
-void ADPlayerCharacter::SlidePlayer()
+void ADPlayerCharacter::SlidePlayer(float CurveFloatValue)
 {
-	float TimelineValue = SlideTimeline.GetPlaybackPosition();
-	float CurveFloatValue = SlideCurve->GetFloatValue(TimelineValue);
-
 	// Calculate Half Height
 	float HalfHeight = FMath::GetMappedRangeValueClamped(FVector2D(0.f, 1.f), FVector2D(StandingHalfHeight, SlideHalfHeight), CurveFloatValue);
 	GetCapsuleComponent()->SetCapsuleHalfHeight(HalfHeight);
@@ -233,7 +443,155 @@ void ADPlayerCharacter::SlidePlayer()
 	GetCharacterMovement()->Velocity = GetActorForwardVector() * sprintSpeed;
 }
 
+UDCharacterMovementComponent* ADPlayerCharacter::GetDCharacterMovement() const
+{
+	return CastChecked<UDCharacterMovementComponent>(GetCharacterMovement());
+}
+
+FVector ADPlayerCharacter::GetExposedHeadLocation() const
+{
+	return GetFirstPersonCameraComponent()->GetComponentLocation();
+}
+
+void ADPlayerCharacter::FixedStep(float StepDelta)
+{
+	AddMovementInput(FixedStepMovementInput, 1.f, true);
+
+	CameraTiltTimeline.Tick(StepDelta);
+	SlideTimeline.Tick(StepDelta);
+
+	UCharacterMovementComponent* CharacterMovementComp = GetCharacterMovement();
+	CharacterMovementComp->TickComponent(StepDelta, LEVELTICK_All, &CharacterMovementComp->PrimaryComponentTick);
+}
+
+void ADPlayerCharacter::HashFixedStepState(uint32& InOutHash) const
+{
+	const FVector Location = GetActorLocation();
+	const FVector Velocity = GetCharacterMovement()->Velocity;
+	const uint8 State[] = { (uint8)MovementState, (uint8)GetCharacterMovement()->MovementMode.GetValue() };
+	const float TimelinePositions[] = { CameraTiltTimeline.GetPlaybackPosition(), SlideTimeline.GetPlaybackPosition() };
+
+	InOutHash = FCrc::MemCrc32(&Location, sizeof(Location), InOutHash);
+	InOutHash = FCrc::MemCrc32(&Velocity, sizeof(Velocity), InOutHash);
+	InOutHash = FCrc::MemCrc32(State, sizeof(State), InOutHash);
+	InOutHash = FCrc::MemCrc32(TimelinePositions, sizeof(TimelinePositions), InOutHash);
+}
+
+void ADPlayerCharacter::SetPresentationOffset(const FVector& Offset)
+{
+	PresentationOffset = Offset;
+}
+
+float ADPlayerCharacter::GetLightExposure() const
+{
+	const UDLightExposureSubsystem* LightExposure = GetWorld()->GetSubsystem<UDLightExposureSubsystem>();
+	return LightExposure ? LightExposure->GetLightExposure(this) : 0.f;
+}
+
+UAISense_Sight::EVisibilityResult ADPlayerCharacter::CanBeSeenFrom(const FCanBeSeenFromContext& Context, FVector& OutSeenLocation, int32& OutNumberOfLoSChecksPerformed, int32& OutNumberOfAsyncLosCheckRequested, float& OutSightStrength, int32* UserData, const FOnPendingVisibilityQueryProcessedDelegate* Delegate)
+{
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(DPlayerSightCheck), true, Context.IgnoreActor);
+	Params.AddIgnoredActor(this);
+
+	// Check the head first, leaning round a corner exposes it before the body
+	const FVector CheckLocations[] = { GetExposedHeadLocation(), GetActorLocation() };
+	for (const FVector& CheckLocation : CheckLocations)
+	{
+		OutNumberOfLoSChecksPerformed++;
+		if (!GetWorld()->LineTraceTestByChannel(Context.ObserverLocation, CheckLocation, ECC_Visibility, Params))
+		{
+			OutSeenLocation = CheckLocation;
+			OutSightStrength = 1.f;
+			return UAISense_Sight::EVisibilityResult::Visible;
+		}
+	}
+
+	OutSightStrength = 0.f;
+	return UAISense_Sight::EVisibilityResult::NotVisible;
+}
+
 bool ADPlayerCharacter::ShouldConsiderMoveInput()
 {
 	return MovementState != EMovementState::Slide;
 }
+
+void ADPlayerCharacter::SetMovementState(EMovementState NewState)
+{
+	if (NewState == MovementState) { return; }
+
+	if (UDMovementEventBus* MovementEventBus = GetWorld()->GetSubsystem<UDMovementEventBus>())
+	{
+		MovementEventBus->QueueTransition(this, MovementState, NewState);
+	}
+	MovementState = NewState;
+}
+
+void ADPlayerCharacter::NotifyMovementStateChanged(EMovementState PreviousState, EMovementState NewState)
+{
+	// Only go through reflection when a Blueprint is actually listening
+	if (OnMovementStateChangedDelegate.IsBound())
+	{
+		OnMovementStateChangedDelegate.Broadcast(PreviousState, NewState);
+	}
+}
+
+void ADPlayerCharacter::NotifyCrouchChanged()
+{
+	// Crouching and standing back up inside one frame sends nothing
+	if (bIsCrouched == bNotifiedCrouched) { return; }
+
+	bNotifiedCrouched = bIsCrouched;
+	if (OnCrouchChangedDelegate.IsBound())
+	{
+		OnCrouchChangedDelegate.Broadcast(bNotifiedCrouched);
+	}
+}
+
+void ADPlayerCharacter::UpdateLean(float DeltaTime)
+{
+	float TargetAlpha = ShouldConsiderMoveInput() ? LeanInput : 0.f;
+	bool bBlocked = false;
+
+	// Only probe while the player is asking to lean, settling back upright is always safe
+	if (TargetAlpha != 0.f)
+	{
+		const FVector CameraLocation = GetFirstPersonCameraComponent()->GetRelativeLocation();
+		const FVector Start = GetCapsuleComponent()->GetComponentTransform().TransformPosition(FVector(CameraLocation.X, StandingYOffset, CameraLocation.Z));
+		const FVector End = Start + GetActorRightVector() * (TargetAlpha * LeanDistance);
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(DLeanProbe), false, this);
+		FHitResult Hit;
+		if (GetWorld()->SweepSingleByChannel(Hit, Start, End, FQuat::Identity, ECC_Camera, FCollisionShape::MakeSphere(LeanProbeRadius), Params))
+		{
+			TargetAlpha *= Hit.Time;
+			bBlocked = true;
+		}
+	}
+
+	LeanAlpha = FMath::FInterpTo(LeanAlpha, TargetAlpha, DeltaTime, LeanInterpSpeed);
+
+	// Never let the interpolation carry the camera into a wall
+	if (bBlocked && FMath::Abs(LeanAlpha) > FMath::Abs(TargetAlpha))
+	{
+		LeanAlpha = TargetAlpha;
+	}
+	if (TargetAlpha == 0.f && FMath::Abs(LeanAlpha) < KINDA_SMALL_NUMBER)
+	{
+		LeanAlpha = 0.f;
+	}
+
+	FVector CameraLocation = GetFirstPersonCameraComponent()->GetRelativeLocation();
+	CameraLocation.Y = StandingYOffset + LeanAlpha * LeanDistance;
+	GetFirstPersonCameraComponent()->SetRelativeLocation(CameraLocation);
+
+	ApplyCameraRoll();
+}
+
+void ADPlayerCharacter::ApplyCameraRoll()
+{
+	if (GetController() == nullptr) { return; }
+
+	FRotator CurrentRotation = GetController()->GetControlRotation();
+	FRotator NewRotation = FRotator(CurrentRotation.Pitch, CurrentRotation.Yaw, SlideTiltRoll + LeanAlpha * LeanRoll);
+	GetController()->SetControlRotation(NewRotation);
+}
@@ -5,19 +5,208 @@
 #include "EnhancedInputSubsystems.h"
 #include "Engine/LocalPlayer.h"
 #include "Blueprint/UserWidget.h"
+#include "Dishonored.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Gameplay/LoadTest/DBotDriverComponent.h"
+#include "Gameplay/Player/DPrebindInputPawn.h"
+#include "Gameplay/Startup/DStartupTimingSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_CYCLE_STAT(TEXT("Possession Swap"), STAT_DPossessionSwap, STATGROUP_Dishonored);
+
+namespace DPossession
+{
+	static float FrameBudgetMs = 16.6f;
+	static FAutoConsoleVariableRef CVarFrameBudgetMs(
+		TEXT("d.Possession.FrameBudgetMs"),
+		FrameBudgetMs,
+		TEXT("Frame time a possession swap frame has to stay within, a warning is logged when it doesn't"));
+}
 
 void ADPlayerController::BeginPlay()
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerController::BeginPlay);
+
 	Super::BeginPlay();
 
 	// get the enhanced input subsystem
 	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerController::AddMappingContext);
+
 		// add the mapping context so we get controls
 		Subsystem->AddMappingContext(InputMappingContext, 0);
 	}
 
-	HUD = CreateWidget<UUserWidget>(this, HUDClass);
+	UDStartupTimingSubsystem* StartupTiming = UGameInstance::GetSubsystem<UDStartupTimingSubsystem>(GetGameInstance());
+	if (StartupTiming != nullptr && IsLocalController())
+	{
+		StartupTiming->MarkPhase(TEXT("InputMappingAdded"));
+	}
+
+	// Load test bots play through injected input and nobody watches them, so they get no HUD
+	if (IsLocalController() && UDBotDriverComponent::IsBotClient())
+	{
+		UDBotDriverComponent* BotDriver = NewObject<UDBotDriverComponent>(this);
+		BotDriver->RegisterComponent();
+		return;
+	}
+
+	// Only a local player has a viewport, on a server this runs for every remote controller too
+	if (IsLocalController() && HUDClass != nullptr)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerController::CreateHUD);
+
+		HUD = CreateWidget<UUserWidget>(this, HUDClass);
+		if (HUD != nullptr)
+		{
+			HUD->AddToViewport();
+		}
+	}
+
+	if (StartupTiming != nullptr && IsLocalController())
+	{
+		StartupTiming->MarkPhase(TEXT("HUDCreated"));
+	}
+}
+
+void ADPlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+
+	// This frame's delta is how long the previous frame took. A swap can happen inside Super::PlayerTick
+	// (or a timer after it), so wait for the next frame to measure the frame it happened on
+	const float FrameMs = DeltaTime * 1000.f;
+	if (PendingSwapMs >= 0.0 && GFrameCounter > SwapFrame)
+	{
+		const bool bOverBudget = FrameMs > DPossession::FrameBudgetMs;
+		UE_LOG(LogDishonored, Display, TEXT("Possession: swap took %.3f ms, swap frame %.2f ms (average %.2f ms, budget %.2f ms)"),
+			PendingSwapMs, FrameMs, AverageFrameMs, DPossession::FrameBudgetMs);
+		UE_CLOG(bOverBudget, LogDishonored, Warning, TEXT("Possession: swap frame went over the %.2f ms frame budget"), DPossession::FrameBudgetMs);
+		PendingSwapMs = -1.0;
+	}
+
+	AverageFrameMs = AverageFrameMs > 0.f ? FMath::Lerp(AverageFrameMs, FrameMs, 0.05f) : FrameMs;
+}
+
+void ADPlayerController::BuildInputStack(TArray<UInputComponent*>& InputStack)
+{
+	Super::BuildInputStack(InputStack);
+
+	// CurrentInputStack only has the pushed components, the pawn's is added here
+	LastInputStack.Reset();
+	for (UInputComponent* Component : InputStack)
+	{
+		LastInputStack.Add(Component);
+	}
+}
+
+bool ADPlayerController::IsReceivingInput(const UInputComponent* Component) const
+{
+	return Component != nullptr && LastInputStack.ContainsByPredicate([Component](const TWeakObjectPtr<UInputComponent>& Entry) { return Entry.Get() == Component; });
+}
+
+void ADPlayerController::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ADPlayerController, OwnBody, COND_OwnerOnly);
+}
+
+bool ADPlayerController::CanPossess(const APawn* Target) const
+{
+	return Target != nullptr && Target != GetPawn() && !IsPossessing() && !Target->IsPlayerControlled();
+}
+
+bool ADPlayerController::BeginPossession(APawn* Target)
+{
+	if (!CanPossess(Target)) { return false; }
+
+	// Only the server can swap pawns, it starts the timer once it has
+	if (!HasAuthority())
+	{
+		ServerBeginPossession(Target);
+		return true;
+	}
+
+	OwnBody = GetPawn();
+	SwapPawn(Target);
+	GetWorldTimerManager().SetTimer(PossessionTimerHandle, this, &ADPlayerController::EndPossession, PossessionDuration);
+	return true;
+}
+
+void ADPlayerController::ServerBeginPossession_Implementation(APawn* Target)
+{
+	BeginPossession(Target);
+}
+
+void ADPlayerController::EndPossession()
+{
+	if (!HasAuthority())
+	{
+		ServerEndPossession();
+		return;
+	}
+
+	GetWorldTimerManager().ClearTimer(PossessionTimerHandle);
+
+	APawn* Body = OwnBody.Get();
+	OwnBody.Reset();
+	if (Body != nullptr)
+	{
+		SwapPawn(Body);
+	}
+}
+
+void ADPlayerController::ServerEndPossession_Implementation()
+{
+	EndPossession();
+}
+
+void ADPlayerController::SwapPawn(APawn* NewPawn)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADPlayerController::SwapPawn);
+	SCOPE_CYCLE_COUNTER(STAT_DPossessionSwap);
+
+	APawn* OldPawn = GetPawn();
+	if (!HasAuthority() || NewPawn == nullptr || NewPawn == OldPawn) { return; }
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Whoever was driving the new pawn (usually an AI controller) steps aside until we leave
+	if (AController* PreviousController = NewPawn->GetController())
+	{
+		DisplacedControllers.Add(NewPawn, PreviousController);
+		PreviousController->UnPossess();
+	}
+
+	// The HUD and mapping contexts belong to us and stay as they are. Pawns that can prebind their input
+	// keep it between possessions, so possessing them doesn't rebuild their bindings either
+	IDPrebindInputPawn* PrebindInputPawn = Cast<IDPrebindInputPawn>(NewPawn);
+	if (PrebindInputPawn != nullptr && IsLocalController())
+	{
+		PrebindInputPawn->PrebindInput();
+	}
+	Possess(NewPawn);
+
+	if (OldPawn != nullptr)
+	{
+		TWeakObjectPtr<AController> DisplacedController;
+		if (DisplacedControllers.RemoveAndCopyValue(OldPawn, DisplacedController) && DisplacedController.IsValid())
+		{
+			DisplacedController->Possess(OldPawn);
+		}
+
+		// Possess snaps the camera to the new pawn, put it back and blend across instead
+		SetViewTarget(OldPawn);
+		SetViewTargetWithBlend(NewPawn, PossessionBlendTime, VTBlend_Cubic);
+	}
 
-	HUD->AddToViewport();
+	PendingSwapMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	SwapFrame = GFrameCounter;
 }
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Powers/DTimeControlSubsystem.h"
+#include "Dishonored.h"
+#include "Components/PrimitiveComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/HUD.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/MovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Time Control Freeze"), STAT_DTimeControlFreeze, STATGROUP_Dishonored);
+DECLARE_CYCLE_STAT(TEXT("Time Control Thaw"), STAT_DTimeControlThaw, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Time Control Frozen Actors"), STAT_DTimeControlFrozenActors, STATGROUP_Dishonored);
+
+bool UDTimeControlSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDTimeControlSubsystem::Deinitialize()
+{
+	ResumeTime();
+
+	Super::Deinitialize();
+}
+
+void UDTimeControlSubsystem::StopTime(AActor* Caster)
+{
+	if (bTimeStopped) { return; }
+
+	SCOPE_CYCLE_COUNTER(STAT_DTimeControlFreeze);
+	bTimeStopped = true;
+
+	// The caster and whatever they are holding keep moving
+	ExemptActors.Reset();
+	if (Caster != nullptr)
+	{
+		ExemptActors.Add(Caster);
+
+		TArray<AActor*> AttachedActors;
+		Caster->GetAttachedActors(AttachedActors, false, true);
+		for (AActor* Attached : AttachedActors)
+		{
+			ExemptActors.Add(Attached);
+		}
+	}
+
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		if (ShouldFreeze(*It))
+		{
+			FreezeActor(*It);
+		}
+	}
+
+	// Anything spawned while time is stopped (shots fired by the caster included) freezes on the spot
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UDTimeControlSubsystem::OnActorSpawned));
+}
+
+void UDTimeControlSubsystem::ResumeTime()
+{
+	if (!bTimeStopped) { return; }
+
+	SCOPE_CYCLE_COUNTER(STAT_DTimeControlThaw);
+	bTimeStopped = false;
+
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	ActorSpawnedHandle.Reset();
+
+	for (FFrozenActor& Frozen : FrozenActors)
+	{
+		ThawActor(Frozen);
+	}
+
+	FrozenActors.Reset();
+	FrozenActorKeys.Reset();
+	ExemptActors.Reset();
+	SET_DWORD_STAT(STAT_DTimeControlFrozenActors, 0);
+}
+
+bool UDTimeControlSubsystem::ShouldFreeze(const AActor* Actor) const
+{
+	if (!IsValid(Actor) || ExemptActors.Contains(Actor)) { return false; }
+
+	// Game mode, game state, controllers, cameras and the HUD keep the game running and the caster playing
+	if (Actor->IsA<AInfo>() || Actor->IsA<AController>() || Actor->IsA<APlayerCameraManager>() || Actor->IsA<AHUD>()) { return false; }
+
+	// Actors without a movable root have nothing to freeze in place
+	const USceneComponent* Root = Actor->GetRootComponent();
+	return Root != nullptr && Root->Mobility == EComponentMobility::Movable;
+}
+
+void UDTimeControlSubsystem::FreezeActor(AActor* Actor)
+{
+	FFrozenActor& Frozen = FrozenActors.AddDefaulted_GetRef();
+	FrozenActorKeys.Add(Actor);
+	Frozen.Actor = Actor;
+	Frozen.bTickEnabled = Actor->IsActorTickEnabled();
+	Actor->SetActorTickEnabled(false);
+
+	// The life span timer runs on world time, so take it off and put the remainder back later
+	Frozen.RemainingLifeSpan = Actor->GetLifeSpan();
+	if (Frozen.RemainingLifeSpan > 0.f)
+	{
+		Actor->SetLifeSpan(0.f);
+	}
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		UMovementComponent* Movement = Cast<UMovementComponent>(Component);
+		UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		const bool bSimulatingPhysics = Primitive != nullptr && Primitive->IsSimulatingPhysics();
+		if (!Component->IsComponentTickEnabled() && !bSimulatingPhysics && Movement == nullptr) { continue; }
+
+		FFrozenComponent& FrozenComponent = Frozen.Components.AddDefaulted_GetRef();
+		FrozenComponent.Component = Component;
+		FrozenComponent.bTickEnabled = Component->IsComponentTickEnabled();
+		Component->SetComponentTickEnabled(false);
+
+		if (Movement != nullptr)
+		{
+			FrozenComponent.MovementVelocity = Movement->Velocity;
+		}
+
+		if (bSimulatingPhysics)
+		{
+			FrozenComponent.bSimulatingPhysics = true;
+			FrozenComponent.LinearVelocity = Primitive->GetPhysicsLinearVelocity();
+			FrozenComponent.AngularVelocity = Primitive->GetPhysicsAngularVelocityInDegrees();
+			Primitive->SetSimulatePhysics(false);
+		}
+	}
+
+	INC_DWORD_STAT(STAT_DTimeControlFrozenActors);
+}
+
+void UDTimeControlSubsystem::ThawActor(FFrozenActor& Frozen)
+{
+	AActor* Actor = Frozen.Actor.Get();
+	if (Actor == nullptr) { return; }
+
+	for (const FFrozenComponent& FrozenComponent : Frozen.Components)
+	{
+		UActorComponent* Component = FrozenComponent.Component.Get();
+		if (Component == nullptr) { continue; }
+
+		if (FrozenComponent.bSimulatingPhysics)
+		{
+			UPrimitiveComponent* Primitive = CastChecked<UPrimitiveComponent>(Component);
+			Primitive->SetSimulatePhysics(true);
+			Primitive->SetPhysicsLinearVelocity(FrozenComponent.LinearVelocity);
+			Primitive->SetPhysicsAngularVelocityInDegrees(FrozenComponent.AngularVelocity);
+		}
+
+		if (UMovementComponent* Movement = Cast<UMovementComponent>(Component))
+		{
+			Movement->Velocity = FrozenComponent.MovementVelocity;
+		}
+
+		Component->SetComponentTickEnabled(FrozenComponent.bTickEnabled);
+	}
+
+	Actor->SetActorTickEnabled(Frozen.bTickEnabled);
+	if (Frozen.RemainingLifeSpan > 0.f)
+	{
+		Actor->SetLifeSpan(Frozen.RemainingLifeSpan);
+	}
+}
+
+void UDTimeControlSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (ShouldFreeze(Actor))
+	{
+		FreezeActor(Actor);
+	}
+}
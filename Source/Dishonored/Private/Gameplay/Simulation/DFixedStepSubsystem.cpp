@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Simulation/DFixedStepSubsystem.h"
+#include "Dishonored.h"
+#include "Gameplay/Powers/DTimeControlSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fixed Step Tick"), STAT_DFixedStepTick, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fixed Steps This Frame"), STAT_DFixedStepsThisFrame, STATGROUP_Dishonored);
+
+namespace DFixedStep
+{
+	static bool bEnabled = false;
+	static FAutoConsoleVariableRef CVarEnabled(
+		TEXT("d.FixedStep.Enable"),
+		bEnabled,
+		TEXT("Simulate player characters and projectiles in fixed steps. Read when actors begin play"));
+
+	static float Rate = 60.f;
+	static FAutoConsoleVariableRef CVarRate(
+		TEXT("d.FixedStep.Rate"),
+		Rate,
+		TEXT("Fixed simulation steps per second"));
+
+	static int32 MaxStepsPerFrame = 8;
+	static FAutoConsoleVariableRef CVarMaxStepsPerFrame(
+		TEXT("d.FixedStep.MaxStepsPerFrame"),
+		MaxStepsPerFrame,
+		TEXT("Most steps run in one frame when catching up, time beyond that is dropped"));
+
+	FString GetHashFilePath(const FString& Name)
+	{
+		return FPaths::ProjectSavedDir() / TEXT("Determinism") / (Name.IsEmpty() ? TEXT("StepHashes") : Name) + TEXT(".txt");
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs SaveHashesCommand(
+		TEXT("d.FixedStep.SaveHashes"),
+		TEXT("Writes the state hash of every fixed step so far to Saved/Determinism/<Name>.txt"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const UDFixedStepSubsystem* FixedStep = World ? World->GetSubsystem<UDFixedStepSubsystem>() : nullptr;
+			if (FixedStep == nullptr) { return; }
+
+			TArray<FString> Lines;
+			Lines.Reserve(FixedStep->GetStepHashes().Num());
+			for (uint32 Hash : FixedStep->GetStepHashes())
+			{
+				Lines.Add(FString::Printf(TEXT("%08x"), Hash));
+			}
+
+			const FString Path = GetHashFilePath(Args.Num() > 0 ? Args[0] : FString());
+			FFileHelper::SaveStringArrayToFile(Lines, *Path);
+			UE_LOG(LogDishonored, Display, TEXT("Fixed step: saved %d step hashes to %s"), Lines.Num(), *Path);
+		}));
+
+	static FAutoConsoleCommandWithWorldAndArgs CompareHashesCommand(
+		TEXT("d.FixedStep.CompareHashes"),
+		TEXT("Compares this run's fixed step hashes against Saved/Determinism/<Name>.txt and reports the first step that differs"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const UDFixedStepSubsystem* FixedStep = World ? World->GetSubsystem<UDFixedStepSubsystem>() : nullptr;
+			if (FixedStep == nullptr) { return; }
+
+			TArray<FString> Lines;
+			const FString Path = GetHashFilePath(Args.Num() > 0 ? Args[0] : FString());
+			if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+			{
+				UE_LOG(LogDishonored, Warning, TEXT("Fixed step: could not read %s"), *Path);
+				return;
+			}
+
+			const TArray<uint32>& Hashes = FixedStep->GetStepHashes();
+			const int32 NumToCompare = FMath::Min(Lines.Num(), Hashes.Num());
+			for (int32 Step = 0; Step < NumToCompare; ++Step)
+			{
+				if (FParse::HexNumber(*Lines[Step]) != Hashes[Step])
+				{
+					UE_LOG(LogDishonored, Warning, TEXT("Fixed step: diverged from %s at step %d"), *Path, Step);
+					return;
+				}
+			}
+			UE_LOG(LogDishonored, Display, TEXT("Fixed step: first %d steps match %s"), NumToCompare, *Path);
+		}));
+}
+
+bool UDFixedStepSubsystem::IsFixedStepEnabled()
+{
+	return DFixedStep::bEnabled;
+}
+
+bool UDFixedStepSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDFixedStepSubsystem::RegisterActor(AActor* Actor)
+{
+	IDFixedStepActor* Stepped = Cast<IDFixedStepActor>(Actor);
+	if (Stepped == nullptr) { return; }
+
+	Participants.Add({ Actor, Stepped, Actor->GetActorLocation() });
+}
+
+float UDFixedStepSubsystem::GetStepDelta() const
+{
+	return 1.f / FMath::Max(DFixedStep::Rate, 1.f);
+}
+
+void UDFixedStepSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DFixedStepTick);
+
+	// Keep registration order, the step hash depends on it
+	Participants.RemoveAll([](const FParticipant& Participant) { return !Participant.Actor.IsValid(); });
+
+	const float StepDelta = GetStepDelta();
+	Accumulator += DeltaTime;
+
+	int32 Steps = 0;
+	while (Accumulator >= StepDelta && Steps < DFixedStep::MaxStepsPerFrame)
+	{
+		RunStep(StepDelta);
+		Accumulator -= StepDelta;
+		Steps++;
+	}
+
+	// Too far behind to catch up, drop the time rather than spiral
+	if (Accumulator >= StepDelta)
+	{
+		Accumulator = FMath::Fmod(Accumulator, StepDelta);
+	}
+	INC_DWORD_STAT_BY(STAT_DFixedStepsThisFrame, Steps);
+
+	// Anything that destroyed itself during a step is dropped before we touch it again
+	Participants.RemoveAll([](const FParticipant& Participant) { return !Participant.Actor.IsValid(); });
+
+	// Draw everything part way between its last two steps
+	const float Alpha = Accumulator / StepDelta;
+	for (const FParticipant& Participant : Participants)
+	{
+		const FVector CurrentLocation = Participant.Actor->GetActorLocation();
+		Participant.Stepped->SetPresentationOffset(FMath::Lerp(Participant.PreviousLocation, CurrentLocation, Alpha) - CurrentLocation);
+	}
+}
+
+void UDFixedStepSubsystem::RunStep(float StepDelta)
+{
+	const UDTimeControlSubsystem* TimeControl = GetWorld()->GetSubsystem<UDTimeControlSubsystem>();
+	uint32 Hash = 0;
+
+	// By index, stepping can destroy participants or spawn and register new ones
+	for (int32 Index = 0; Index < Participants.Num(); ++Index)
+	{
+		FParticipant& Participant = Participants[Index];
+		AActor* Actor = Participant.Actor.Get();
+		if (Actor == nullptr) { continue; }
+
+		Participant.PreviousLocation = Actor->GetActorLocation();
+		if (TimeControl != nullptr && TimeControl->IsActorFrozen(Actor)) { continue; }
+
+		// Participant may not survive the step if it registers someone else
+		IDFixedStepActor* Stepped = Participant.Stepped;
+		Stepped->FixedStep(StepDelta);
+		Stepped->HashFixedStepState(Hash);
+	}
+
+	StepHashes.Add(Hash);
+	StepIndex++;
+}
+
+TStatId UDFixedStepSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDFixedStepSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Startup/DStartupTimingSubsystem.h"
+#include "Dishonored.h"
+#include "Gameplay/Player/DPlayerCharacter.h"
+#include "Gameplay/Player/DPlayerController.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "UObject/UObjectGlobals.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
+
+namespace DStartupTiming
+{
+	/** How many of the most recent runs the benchmark summary covers by default */
+	constexpr int32 DefaultBenchmarkWindow = 10;
+
+	FString GetBenchmarkFilePath()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("Startup") / TEXT("StartupTimes.txt");
+	}
+}
+
+void UDStartupTimingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UDStartupTimingSubsystem::OnPreLoadMap);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UDStartupTimingSubsystem::OnPostLoadMap);
+
+	MarkPhase(TEXT("EngineInit"));
+}
+
+void UDStartupTimingSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+	Super::Deinitialize();
+}
+
+void UDStartupTimingSubsystem::MarkPhase(const TCHAR* Phase)
+{
+	if (bPlayable || Phases.ContainsByPredicate([Phase](const FPhase& Recorded) { return Recorded.Name == Phase; })) { return; }
+
+	Phases.Add({ Phase, FPlatformTime::Seconds() - GStartTime });
+	TRACE_BOOKMARK(TEXT("Startup: %s"), Phase);
+}
+
+void UDStartupTimingSubsystem::OnPreLoadMap(const FString& MapName)
+{
+	MarkPhase(TEXT("LoadMapStart"));
+}
+
+void UDStartupTimingSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	MarkPhase(TEXT("LoadMapEnd"));
+}
+
+void UDStartupTimingSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (World == nullptr || !World->HasBegunPlay()) { return; }
+
+	// Only partitioned worlds have a streaming subsystem, anything else is loaded with the map
+	if (!bWorldStreamed)
+	{
+		const UWorldPartitionSubsystem* WorldPartition = World->GetSubsystem<UWorldPartitionSubsystem>();
+		if (WorldPartition != nullptr && !WorldPartition->IsAllStreamingCompleted()) { return; }
+
+		bWorldStreamed = true;
+		MarkPhase(TEXT("WorldStreamed"));
+	}
+
+	// Our characters build their bindings before they are possessed, so wait for the controller to actually route input to them
+	const ADPlayerController* PlayerController = Cast<ADPlayerController>(World->GetFirstPlayerController());
+	const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (Pawn == nullptr || !PlayerController->IsLocalController() || !Pawn->IsA<ADPlayerCharacter>() || !PlayerController->IsReceivingInput(Pawn->InputComponent)) { return; }
+
+	MarkPhase(TEXT("Playable"));
+	bPlayable = true;
+	ReportPhases();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("DStartupBenchmark")))
+	{
+		RecordBenchmarkRun();
+	}
+}
+
+void UDStartupTimingSubsystem::ReportPhases() const
+{
+	UE_LOG(LogDishonored, Display, TEXT("Startup: playable %.3f s after launch"), Phases.Last().Time);
+
+	double PreviousTime = 0.0;
+	for (const FPhase& Phase : Phases)
+	{
+		UE_LOG(LogDishonored, Display, TEXT("Startup:   %-20s %8.3f s  (+%.3f s)"), *Phase.Name, Phase.Time, Phase.Time - PreviousTime);
+		PreviousTime = Phase.Time;
+	}
+}
+
+void UDStartupTimingSubsystem::RecordBenchmarkRun() const
+{
+	// One line per run, each phase as Name=SecondsSinceStart, the total last
+	TArray<FString> Entries;
+	for (const FPhase& Phase : Phases)
+	{
+		Entries.Add(FString::Printf(TEXT("%s=%.4f"), *Phase.Name, Phase.Time));
+	}
+	Entries.Add(FString::Printf(TEXT("Total=%.4f"), Phases.Last().Time));
+
+	const FString Path = DStartupTiming::GetBenchmarkFilePath();
+	FFileHelper::SaveStringToFile(FString::Join(Entries, TEXT(",")) + LINE_TERMINATOR, *Path, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	// Summarise the most recent runs, older ones were measured against different code
+	TArray<FString> Runs;
+	FFileHelper::LoadFileToStringArray(Runs, *Path);
+	Runs.RemoveAll([](const FString& Run) { return Run.IsEmpty(); });
+
+	int32 Window = DStartupTiming::DefaultBenchmarkWindow;
+	FParse::Value(FCommandLine::Get(), TEXT("DStartupBenchmarkWindow="), Window);
+	if (Window > 0 && Runs.Num() > Window)
+	{
+		Runs.RemoveAt(0, Runs.Num() - Window);
+	}
+
+	TArray<FString> PhaseOrder;
+	TMap<FString, TArray<double>> SamplesByPhase;
+	for (const FString& Run : Runs)
+	{
+		TArray<FString> RunEntries;
+		Run.ParseIntoArray(RunEntries, TEXT(","));
+		for (const FString& Entry : RunEntries)
+		{
+			FString Name, Value;
+			if (!Entry.Split(TEXT("="), &Name, &Value)) { continue; }
+
+			if (!SamplesByPhase.Contains(Name))
+			{
+				PhaseOrder.Add(Name);
+			}
+			SamplesByPhase.FindOrAdd(Name).Add(FCString::Atod(*Value));
+		}
+	}
+
+	UE_LOG(LogDishonored, Display, TEXT("Startup benchmark: %d runs in %s"), Runs.Num(), *Path);
+
+	// Medians are over the time each phase was reached, the time spent in it is only worked out for display
+	double TotalMedian = 0.0;
+	double PreviousMedian = 0.0;
+	for (const FString& Name : PhaseOrder)
+	{
+		TArray<double>& Samples = SamplesByPhase[Name];
+		Samples.Sort();
+		const int32 Num = Samples.Num();
+		const double Median = Num % 2 ? Samples[Num / 2] : (Samples[Num / 2 - 1] + Samples[Num / 2]) * 0.5;
+
+		double Mean = 0.0;
+		for (double Sample : Samples) { Mean += Sample; }
+		Mean /= Num;
+		double Variance = 0.0;
+		for (double Sample : Samples) { Variance += FMath::Square(Sample - Mean); }
+		Variance /= Num;
+
+		if (Name == TEXT("Total"))
+		{
+			UE_LOG(LogDishonored, Display, TEXT("Startup benchmark:   %-20s median %8.3f s  stddev %.3f s  (%d runs)"), *Name, Median, FMath::Sqrt(Variance), Num);
+			TotalMedian = Median;
+			continue;
+		}
+
+		UE_LOG(LogDishonored, Display, TEXT("Startup benchmark:   %-20s median %8.3f s (+%.3f s)  stddev %.3f s  (%d runs)"), *Name, Median, Median - PreviousMedian, FMath::Sqrt(Variance), Num);
+		PreviousMedian = Median;
+	}
+
+	// Gate on the median so one noisy run doesn't fail the check
+	double BudgetMs = 0.0;
+	const bool bOverBudget = FParse::Value(FCommandLine::Get(), TEXT("DStartupBudgetMs="), BudgetMs) && TotalMedian * 1000.0 > BudgetMs;
+	if (bOverBudget)
+	{
+		UE_LOG(LogDishonored, Error, TEXT("Startup benchmark: median time to playable %.0f ms is over the %.0f ms budget"), TotalMedian * 1000.0, BudgetMs);
+	}
+
+	FPlatformMisc::RequestExitWithStatus(false, bOverBudget ? 1 : 0);
+}
+
+TStatId UDStartupTimingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDStartupTimingSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,484 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Stealth/DLightExposureSubsystem.h"
+#include "Dishonored.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/DirectionalLightComponent.h"
+#include "Components/LocalLightComponent.h"
+#include "Components/SpotLightComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Light Exposure Tick"), STAT_DLightExposureTick, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Light Exposure Traces"), STAT_DLightExposureTraces, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Light Exposure Lights"), STAT_DLightExposureLights, STATGROUP_Dishonored);
+
+namespace DLightExposure
+{
+	/** Grid cell size, roughly the radius of a typical room light */
+	constexpr float CellSize = 1000.f;
+	/** Lights covering more cells than this are checked against every sample instead */
+	constexpr int32 MaxCellsPerLight = 64;
+	/** How far back along a directional light we trace for occlusion */
+	constexpr float DirectionalTraceDistance = 50000.f;
+	/** Movement needed before a character is resampled */
+	constexpr float ResampleDistance = 10.f;
+
+	static int32 TraceBudget = 64;
+	static FAutoConsoleVariableRef CVarTraceBudget(
+		TEXT("d.LightExposure.TraceBudget"),
+		TraceBudget,
+		TEXT("Maximum number of light occlusion traces issued per frame"));
+
+	static float LocalReferenceIntensity = 5000.f;
+	static FAutoConsoleVariableRef CVarLocalReferenceIntensity(
+		TEXT("d.LightExposure.LocalReferenceIntensity"),
+		LocalReferenceIntensity,
+		TEXT("Point/spot light intensity that fully lights a character standing right next to it"));
+
+	static float DirectionalReferenceIntensity = 10.f;
+	static FAutoConsoleVariableRef CVarDirectionalReferenceIntensity(
+		TEXT("d.LightExposure.DirectionalReferenceIntensity"),
+		DirectionalReferenceIntensity,
+		TEXT("Directional light intensity that fully lights a character in the open"));
+}
+
+bool UDLightExposureSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDLightExposureSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		IndexLevel(Level);
+	}
+
+	// World Partition streams cells in after begin play
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UDLightExposureSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UDLightExposureSubsystem::OnLevelRemoved);
+}
+
+void UDLightExposureSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	for (const FLightEntry& Entry : Lights)
+	{
+		if (ULightComponent* Light = Entry.Light.Get())
+		{
+			Light->TransformUpdated.RemoveAll(this);
+		}
+	}
+
+	Super::Deinitialize();
+}
+
+void UDLightExposureSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (Character == nullptr) { return; }
+
+	FSubject& Subject = Subjects.AddDefaulted_GetRef();
+	Subject.Character = Character;
+	Subject.SampledLocation = Character->GetActorLocation();
+	Subject.SampledHalfHeight = 0.f;
+	Subject.bDirty = true;
+	Subject.Exposure = 0.f;
+}
+
+float UDLightExposureSubsystem::GetLightExposure(const ACharacter* Character) const
+{
+	for (const FSubject& Subject : Subjects)
+	{
+		if (Subject.Character.Get() == Character)
+		{
+			return Subject.Exposure;
+		}
+	}
+	return 0.f;
+}
+
+void UDLightExposureSubsystem::RegisterLight(ULightComponent* Light)
+{
+	if (Light == nullptr || LightIndices.Contains(Light)) { return; }
+
+	FLightEntry Entry;
+	Entry.Light = Light;
+	Entry.Location = Light->GetComponentLocation();
+	Entry.Direction = Light->GetDirection();
+	Entry.bDirectional = Light->IsA<UDirectionalLightComponent>();
+	Entry.Radius = 0.f;
+	Entry.CosOuterCone = -1.f;
+
+	if (const ULocalLightComponent* LocalLight = Cast<ULocalLightComponent>(Light))
+	{
+		Entry.Radius = LocalLight->AttenuationRadius;
+	}
+	if (const USpotLightComponent* SpotLight = Cast<USpotLightComponent>(Light))
+	{
+		Entry.CosOuterCone = FMath::Cos(FMath::DegreesToRadians(SpotLight->OuterConeAngle));
+	}
+
+	// Sky lights don't have a position or a direction we can trace along
+	if (!Entry.bDirectional && Entry.Radius <= 0.f) { return; }
+
+	const int32 LightIndex = Lights.Add(MoveTemp(Entry));
+	LightIndices.Add(Light, LightIndex);
+	UpdateLightCells(LightIndex);
+
+	// Static and stationary lights never move, so only movable ones need watching
+	if (Light->Mobility == EComponentMobility::Movable)
+	{
+		Light->TransformUpdated.AddUObject(this, &UDLightExposureSubsystem::OnLightTransformUpdated);
+	}
+
+	INC_DWORD_STAT(STAT_DLightExposureLights);
+}
+
+void UDLightExposureSubsystem::IndexLevel(ULevel* Level)
+{
+	if (Level == nullptr) { return; }
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor == nullptr) { continue; }
+
+		TInlineComponentArray<ULightComponent*> LightComponents(Actor);
+		for (ULightComponent* Light : LightComponents)
+		{
+			RegisterLight(Light);
+		}
+	}
+}
+
+void UDLightExposureSubsystem::UpdateLightCells(int32 LightIndex)
+{
+	FLightEntry& Entry = Lights[LightIndex];
+
+	for (const FIntVector& Cell : Entry.Cells)
+	{
+		if (TArray<int32>* CellLights = LightGrid.Find(Cell))
+		{
+			CellLights->RemoveSwap(LightIndex);
+		}
+	}
+	Entry.Cells.Reset();
+	LargeLights.RemoveSwap(LightIndex);
+
+	if (Entry.bDirectional)
+	{
+		DirectionalLights.AddUnique(LightIndex);
+		return;
+	}
+
+	const FIntVector MinCell = GetCell(Entry.Location - FVector(Entry.Radius));
+	const FIntVector MaxCell = GetCell(Entry.Location + FVector(Entry.Radius));
+	const FIntVector Extent = MaxCell - MinCell + FIntVector(1);
+	if (Extent.X * Extent.Y * Extent.Z > DLightExposure::MaxCellsPerLight)
+	{
+		LargeLights.Add(LightIndex);
+		return;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				const FIntVector Cell(X, Y, Z);
+				LightGrid.FindOrAdd(Cell).Add(LightIndex);
+				Entry.Cells.Add(Cell);
+			}
+		}
+	}
+}
+
+void UDLightExposureSubsystem::RemoveLight(int32 LightIndex)
+{
+	FLightEntry& Entry = Lights[LightIndex];
+
+	for (const FIntVector& Cell : Entry.Cells)
+	{
+		if (TArray<int32>* CellLights = LightGrid.Find(Cell))
+		{
+			CellLights->RemoveSwap(LightIndex);
+			if (CellLights->Num() == 0)
+			{
+				LightGrid.Remove(Cell);
+			}
+		}
+	}
+	LargeLights.RemoveSwap(LightIndex);
+	DirectionalLights.RemoveSwap(LightIndex);
+
+	if (ULightComponent* Light = Entry.Light.Get())
+	{
+		Light->TransformUpdated.RemoveAll(this);
+	}
+	// The light may already be gone, so find its key by index
+	for (auto It = LightIndices.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == LightIndex)
+		{
+			It.RemoveCurrent();
+			break;
+		}
+	}
+	// Anyone it was lighting is now darker
+	DirtySubjectsLitBy(Entry);
+	Lights.RemoveAt(LightIndex);
+
+	DEC_DWORD_STAT(STAT_DLightExposureLights);
+}
+
+void UDLightExposureSubsystem::DirtySubjectsLitBy(const FLightEntry& Entry)
+{
+	for (FSubject& Subject : Subjects)
+	{
+		const ACharacter* Character = Subject.Character.Get();
+		if (Character == nullptr) { continue; }
+
+		if (Entry.bDirectional || FVector::DistSquared(Character->GetActorLocation(), Entry.Location) < FMath::Square(Entry.Radius))
+		{
+			Subject.bDirty = true;
+		}
+	}
+}
+
+void UDLightExposureSubsystem::OnLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld == GetWorld())
+	{
+		IndexLevel(Level);
+	}
+}
+
+void UDLightExposureSubsystem::OnLevelRemoved(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld != GetWorld()) { return; }
+
+	// A null level means the whole world is going away, Deinitialize handles that
+	if (Level == nullptr) { return; }
+
+	// Drop the streamed out level's lights, along with any that were already destroyed
+	TArray<int32> Removed;
+	for (auto It = Lights.CreateConstIterator(); It; ++It)
+	{
+		const ULightComponent* Light = It->Light.Get();
+		if (Light == nullptr || Light->GetComponentLevel() == Level)
+		{
+			Removed.Add(It.GetIndex());
+		}
+	}
+	for (int32 LightIndex : Removed)
+	{
+		RemoveLight(LightIndex);
+	}
+}
+
+void UDLightExposureSubsystem::OnLightTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	const int32* LightIndex = LightIndices.Find(Cast<ULightComponent>(Component));
+	if (LightIndex == nullptr) { return; }
+
+	// Anyone the light could reach before or after the move needs resampling
+	FLightEntry& Entry = Lights[*LightIndex];
+	DirtySubjectsLitBy(Entry);
+	Entry.Location = Component->GetComponentLocation();
+	Entry.Direction = Cast<ULightComponent>(Component)->GetDirection();
+	UpdateLightCells(*LightIndex);
+	DirtySubjectsLitBy(Entry);
+}
+
+void UDLightExposureSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DLightExposureTick);
+
+	SweepDeadLights();
+
+	for (int32 Index = Subjects.Num() - 1; Index >= 0; --Index)
+	{
+		FSubject& Subject = Subjects[Index];
+		const ACharacter* Character = Subject.Character.Get();
+		if (Character == nullptr)
+		{
+			Subjects.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// Moving during an evaluation queues another one after it rather than starting over
+		const float HalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		if (FVector::DistSquared(Character->GetActorLocation(), Subject.SampledLocation) > FMath::Square(DLightExposure::ResampleDistance)
+			|| !FMath::IsNearlyEqual(HalfHeight, Subject.SampledHalfHeight))
+		{
+			Subject.bDirty = true;
+		}
+	}
+
+	if (Subjects.Num() == 0) { return; }
+	NextSubject = NextSubject % Subjects.Num();
+
+	// Work through dirty subjects round robin, checking the budget before every trace.
+	// A subject that runs out part way keeps its place and is first in line next frame
+	const int32 TraceBudget = FMath::Max(DLightExposure::TraceBudget, 1);
+	int32 Traces = 0;
+	const int32 NumSubjects = Subjects.Num();
+	for (int32 Offset = 0; Offset < NumSubjects; ++Offset)
+	{
+		const int32 Index = (NextSubject + Offset) % NumSubjects;
+		FSubject& Subject = Subjects[Index];
+		if (!Subject.bSampling)
+		{
+			if (!Subject.bDirty) { continue; }
+			BeginSample(Subject);
+		}
+
+		if (!ContinueSample(Subject, Traces, TraceBudget))
+		{
+			NextSubject = Index;
+			break;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_DLightExposureTraces, Traces);
+}
+
+void UDLightExposureSubsystem::SweepDeadLights()
+{
+	constexpr int32 LightsPerFrame = 16;
+
+	const int32 MaxIndex = Lights.GetMaxIndex();
+	for (int32 Checked = 0; Checked < LightsPerFrame && MaxIndex > 0; ++Checked)
+	{
+		const int32 LightIndex = NextSweptLight++ % MaxIndex;
+		if (!Lights.IsAllocated(LightIndex)) { continue; }
+
+		const ULightComponent* Light = Lights[LightIndex].Light.Get();
+		if (Light == nullptr || !Light->IsRegistered())
+		{
+			RemoveLight(LightIndex);
+		}
+	}
+	NextSweptLight = MaxIndex > 0 ? NextSweptLight % MaxIndex : 0;
+}
+
+void UDLightExposureSubsystem::BeginSample(FSubject& Subject)
+{
+	const UCapsuleComponent* Capsule = Subject.Character->GetCapsuleComponent();
+	const FVector Center = Capsule->GetComponentLocation();
+	const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	const float Inset = FMath::Min(Capsule->GetScaledCapsuleRadius(), HalfHeight) * 0.5f;
+
+	// Feet, middle and head of the current capsule, which is already shortened when crouching or sliding
+	Subject.SamplePoints[0] = Center - FVector(0.f, 0.f, HalfHeight - Inset);
+	Subject.SamplePoints[1] = Center;
+	Subject.SamplePoints[2] = Center + FVector(0.f, 0.f, HalfHeight - Inset);
+
+	Subject.SampledLocation = Center;
+	Subject.SampledHalfHeight = HalfHeight;
+	Subject.bDirty = false;
+	Subject.bSampling = true;
+	Subject.PointIndex = 0;
+	Subject.LightCursor = 0;
+	Subject.PointExposure = 0.f;
+	Subject.PendingExposure = 0.f;
+}
+
+bool UDLightExposureSubsystem::ContinueSample(FSubject& Subject, int32& InOutTraces, int32 TraceBudget)
+{
+	const int32 NumPoints = UE_ARRAY_COUNT(Subject.SamplePoints);
+	while (Subject.PointIndex < NumPoints)
+	{
+		const TArray<int32>* CellLights = LightGrid.Find(GetCell(Subject.SamplePoints[Subject.PointIndex]));
+		const int32 NumCellLights = CellLights ? CellLights->Num() : 0;
+		const int32 NumLights = NumCellLights + LargeLights.Num() + DirectionalLights.Num();
+
+		// Once a point is fully lit nothing else can change its answer
+		while (Subject.LightCursor < NumLights && Subject.PointExposure < 1.f)
+		{
+			const int32 Cursor = Subject.LightCursor;
+			const int32 LightIndex = Cursor < NumCellLights ? (*CellLights)[Cursor]
+				: Cursor < NumCellLights + LargeLights.Num() ? LargeLights[Cursor - NumCellLights]
+				: DirectionalLights[Cursor - NumCellLights - LargeLights.Num()];
+
+			if (!AddLight(Subject, LightIndex, InOutTraces, TraceBudget))
+			{
+				return false;
+			}
+			Subject.LightCursor++;
+		}
+
+		Subject.PendingExposure = FMath::Max(Subject.PendingExposure, Subject.PointExposure);
+		Subject.PointIndex++;
+		Subject.LightCursor = 0;
+		Subject.PointExposure = 0.f;
+	}
+
+	Subject.Exposure = FMath::Clamp(Subject.PendingExposure, 0.f, 1.f);
+	Subject.bSampling = false;
+	return true;
+}
+
+bool UDLightExposureSubsystem::AddLight(FSubject& Subject, int32 LightIndex, int32& InOutTraces, int32 TraceBudget)
+{
+	const FLightEntry& Entry = Lights[LightIndex];
+	const ULightComponent* Light = Entry.Light.Get();
+	if (Light == nullptr || !Light->IsVisible() || !Light->bAffectsWorld) { return true; }
+
+	const FVector& Point = Subject.SamplePoints[Subject.PointIndex];
+	float Contribution = 0.f;
+	FVector TraceStart;
+	if (Entry.bDirectional)
+	{
+		Contribution = Light->Intensity / DLightExposure::DirectionalReferenceIntensity;
+		TraceStart = Point - Entry.Direction * DLightExposure::DirectionalTraceDistance;
+	}
+	else
+	{
+		const FVector ToPoint = Point - Entry.Location;
+		const float Distance = ToPoint.Size();
+		if (Distance >= Entry.Radius) { return true; }
+		if (Distance > UE_KINDA_SMALL_NUMBER && (ToPoint / Distance | Entry.Direction) < Entry.CosOuterCone) { return true; }
+
+		// Same windowed falloff shape the renderer uses, without the inverse square
+		const float Falloff = FMath::Square(1.f - FMath::Square(Distance / Entry.Radius));
+		Contribution = Falloff * Light->Intensity / DLightExposure::LocalReferenceIntensity;
+		TraceStart = Entry.Location;
+	}
+
+	// Don't pay for a trace that couldn't change the answer
+	if (Contribution <= UE_KINDA_SMALL_NUMBER) { return true; }
+
+	if (InOutTraces >= TraceBudget) { return false; }
+
+	const ACharacter* Character = Subject.Character.Get();
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(DLightExposure), false, Character);
+	Params.AddIgnoredActor(Light->GetOwner());
+	InOutTraces++;
+	if (!GetWorld()->LineTraceTestByChannel(TraceStart, Point, ECC_Visibility, Params))
+	{
+		Subject.PointExposure += Contribution;
+	}
+	return true;
+}
+
+FIntVector UDLightExposureSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / DLightExposure::CellSize),
+		FMath::FloorToInt(Location.Y / DLightExposure::CellSize),
+		FMath::FloorToInt(Location.Z / DLightExposure::CellSize));
+}
+
+TStatId UDLightExposureSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDLightExposureSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Gameplay/Weapons/DBallisticTraceSubsystem.h"
+#include "Dishonored.h"
+#include "DishonoredProjectile.h"
+#include "TP_WeaponComponent.h"
+#include "Gameplay/Powers/DTimeControlSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ballistic Trace Tick"), STAT_DBallisticTraceTick, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ballistic Shots In Flight"), STAT_DBallisticShotsInFlight, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ballistic Segment Traces"), STAT_DBallisticSegmentTraces, STATGROUP_Dishonored);
+
+/** The Projectile object channel from DefaultEngine.ini, so traced shots hit what physical projectiles hit */
+static constexpr ECollisionChannel ECC_DProjectile = ECC_GameTraceChannel1;
+
+void UDBallisticTraceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SegmentTracedDelegate.BindUObject(this, &UDBallisticTraceSubsystem::OnSegmentTraced);
+}
+
+void UDBallisticTraceSubsystem::FireShot(const FVector& Location, const FVector& Velocity, float GravityZ, float MaxFlightTime, AActor* Instigator, UTP_WeaponComponent* Weapon, bool bCosmetic)
+{
+	FShot& Shot = Shots.Add(NextShotId++);
+	Shot.Location = Location;
+	Shot.Velocity = Velocity;
+	Shot.GravityZ = GravityZ;
+	Shot.FlightTime = 0.f;
+	Shot.MaxFlightTime = MaxFlightTime;
+	Shot.Instigator = Instigator;
+	Shot.Weapon = Weapon;
+	Shot.bCosmetic = bCosmetic;
+}
+
+void UDBallisticTraceSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DBallisticTraceTick);
+	SET_DWORD_STAT(STAT_DBallisticShotsInFlight, Shots.Num());
+
+	UWorld* World = GetWorld();
+	if (World == nullptr || DeltaTime <= 0.f) { return; }
+
+	// Shots hang in the air while time is stopped
+	const UDTimeControlSubsystem* TimeControl = World->GetSubsystem<UDTimeControlSubsystem>();
+	if (TimeControl != nullptr && TimeControl->IsTimeStopped()) { return; }
+
+	for (TPair<uint32, FShot>& Pair : Shots)
+	{
+		FShot& Shot = Pair.Value;
+		if (Shot.bTracePending) { continue; }
+
+		// Trace the chord of the arc covered this frame
+		const FVector Acceleration(0.f, 0.f, Shot.GravityZ);
+		Shot.SegmentTime = DeltaTime;
+		Shot.SegmentEnd = Shot.Location + Shot.Velocity * DeltaTime + 0.5f * Acceleration * FMath::Square(DeltaTime);
+		Shot.SegmentEndVelocity = Shot.Velocity + Acceleration * DeltaTime;
+		Shot.bTracePending = true;
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(DBallisticSegment), true, Shot.Instigator.Get());
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Shot.Location, Shot.SegmentEnd, ECC_DProjectile, Params, FCollisionResponseParams::DefaultResponseParam, &SegmentTracedDelegate, Pair.Key);
+		INC_DWORD_STAT(STAT_DBallisticSegmentTraces);
+	}
+}
+
+void UDBallisticTraceSubsystem::OnSegmentTraced(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	FShot* Shot = Shots.Find(Datum.UserData);
+	if (Shot == nullptr) { return; }
+
+	for (const FHitResult& Hit : Datum.OutHits)
+	{
+		if (Hit.bBlockingHit)
+		{
+			if (!Shot->bCosmetic)
+			{
+				ADishonoredProjectile::ApplyImpact(Shot->Instigator.Get(), Hit.GetActor(), Hit.GetComponent(), Shot->Velocity, Hit.ImpactPoint);
+			}
+			if (UTP_WeaponComponent* Weapon = Shot->Weapon.Get())
+			{
+				Weapon->PlayImpactSound(Hit.ImpactPoint);
+			}
+			Shots.Remove(Datum.UserData);
+			return;
+		}
+	}
+
+	Shot->Location = Shot->SegmentEnd;
+	Shot->Velocity = Shot->SegmentEndVelocity;
+	Shot->FlightTime += Shot->SegmentTime;
+	Shot->bTracePending = false;
+
+	if (Shot->FlightTime >= Shot->MaxFlightTime)
+	{
+		Shots.Remove(Datum.UserData);
+	}
+}
+
+TStatId UDBallisticTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDBallisticTraceSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "DGuardNavigationSubsystem.generated.h"
+
+/** Called with the path found for a guard, or null if the goal can't be reached */
+DECLARE_DELEGATE_OneParam(FOnGuardPathReady, FNavPathSharedPtr /*Path*/);
+
+/**
+ * Path finding service for guards, so a group chasing a sprinting and sliding player doesn't
+ * flood the navigation system with a query per guard per repath.
+ * Requests are quantized to start and goal cells. A request whose cells match a cached path
+ * gets it back straight away, one matching a query already queued or running joins it, and the
+ * rest are queued and handed to the navigation system's async path finding, at most
+ * d.GuardNav.MaxSubmitsPerFrame a frame and d.GuardNav.MaxQueriesInFlight at once, so the
+ * searches themselves stay off the game thread.
+ * Cached paths are registered with the nav data, so a nav mesh rebuild only invalidates the paths
+ * crossing the rebuilt tiles and only those are queried again, the next time a guard asks for them.
+ */
+UCLASS()
+class DISHONORED_API UDGuardNavigationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Asks for a path from Start to Goal. OnReady is called right away on a cache hit,
+	 * otherwise on a later frame. Returns an id for CancelRequest, 0 if OnReady was already called
+	 */
+	uint32 RequestPath(const FVector& Start, const FVector& Goal, FOnGuardPathReady OnReady);
+
+	/** Drops a request that has not completed yet, its OnReady will not be called */
+	void CancelRequest(uint32 RequestId);
+
+	/** Simulates NumGuards guards chasing the player (or a moving point) for Duration seconds and logs the throughput */
+	void StartBenchmark(int32 NumGuards, float Duration);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return QueueOrder.Num() > 0 || Benchmark.bRunning; }
+
+private:
+	struct FPathCacheKey
+	{
+		FIntVector StartCell;
+		FIntVector GoalCell;
+
+		bool operator==(const FPathCacheKey& Other) const { return StartCell == Other.StartCell && GoalCell == Other.GoalCell; }
+		friend uint32 GetTypeHash(const FPathCacheKey& Key) { return HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.GoalCell)); }
+	};
+
+	struct FCachedPath
+	{
+		FNavPathSharedPtr Path;
+		double LastUsedTime = 0.0;
+	};
+
+	struct FWaitingRequest
+	{
+		uint32 RequestId;
+		FOnGuardPathReady OnReady;
+	};
+
+	struct FPendingQuery
+	{
+		FVector Start;
+		FVector Goal;
+		TArray<FWaitingRequest> Waiting;
+		/** Async query id once submitted, 0 while still queued */
+		uint32 QueryId = 0;
+	};
+
+	struct FBenchmark
+	{
+		bool bRunning = false;
+		double StartTime = 0.0;
+		double EndTime = 0.0;
+		double NextRepathTime = 0.0;
+		double NextTargetMoveTime = 0.0;
+		FVector Target = FVector::ZeroVector;
+		TArray<FVector> GuardLocations;
+		/** Counters when the benchmark started */
+		int64 StartRequests = 0;
+		int64 StartCacheHits = 0;
+		int64 StartQueries = 0;
+	};
+
+	FPathCacheKey MakeKey(const FVector& Start, const FVector& Goal) const;
+	/** Returns the cached path for Key if there is one the nav mesh hasn't invalidated */
+	FNavPathSharedPtr FindCachedPath(const FPathCacheKey& Key);
+	void AddCachedPath(const FPathCacheKey& Key, FNavPathSharedPtr Path);
+	/** Hands a queued query to async path finding. Returns false if there is no nav data and the query was completed right away */
+	bool SubmitQuery(const FPathCacheKey& Key);
+	void OnQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+	/** Removes the query for Key and hands Path to everyone waiting on it */
+	void CompleteQuery(const FPathCacheKey& Key, FNavPathSharedPtr Path);
+	void TickBenchmark();
+
+	TMap<FPathCacheKey, FCachedPath> PathCache;
+	TMap<FPathCacheKey, FPendingQuery> PendingQueries;
+	/** Pending query keys not submitted yet, oldest first */
+	TArray<FPathCacheKey> QueueOrder;
+	/** Keys of submitted queries, by async query id */
+	TMap<uint32, FPathCacheKey> InFlightQueries;
+	TMap<uint32, FPathCacheKey> RequestKeys;
+	uint32 NextRequestId = 1;
+
+	int64 TotalRequests = 0;
+	int64 TotalCacheHits = 0;
+	int64 TotalQueries = 0;
+
+	FBenchmark Benchmark;
+};
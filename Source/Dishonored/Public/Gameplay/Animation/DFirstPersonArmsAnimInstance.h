@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "DFirstPersonArmsAnimInstance.generated.h"
+
+/** Times the arms graph update and evaluation, which run on worker threads with multithreaded animation update */
+struct FDFirstPersonArmsAnimInstanceProxy : public FAnimInstanceProxy
+{
+	FDFirstPersonArmsAnimInstanceProxy() = default;
+	FDFirstPersonArmsAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+	{
+	}
+
+protected:
+	virtual void UpdateAnimationNode(const FAnimationUpdateContext& InContext) override;
+	virtual bool Evaluate(FPoseContext& Output) override;
+};
+
+/**
+ * Parent class for the first person arms anim blueprint. Defaults to multithreaded animation
+ * update and reports the worker thread cost of the arms under stat Dishonored.
+ */
+UCLASS(Transient, Blueprintable)
+class DISHONORED_API UDFirstPersonArmsAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	UDFirstPersonArmsAnimInstance();
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+};
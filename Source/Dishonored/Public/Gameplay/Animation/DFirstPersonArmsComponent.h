@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "DFirstPersonArmsComponent.generated.h"
+
+class UAnimMontage;
+
+/**
+ * Skeletal mesh for first person arms (Mesh1P). The arms are attached to the camera, so looking
+ * and leaning move them without any animation work. When the owner is standing still with no
+ * montage playing, the last pose is held and the anim instance is neither updated nor evaluated
+ * until something changes. Montages started through PlayMontageCoalesced play out before they
+ * are started again, so sustained fire loops the fire montage instead of restarting it each shot.
+ * Update and evaluation run on worker threads when the arms anim blueprint uses multithreaded
+ * animation update, timed under stat Dishonored when it derives from UDFirstPersonArmsAnimInstance.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class DISHONORED_API UDFirstPersonArmsComponent : public USkeletalMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDFirstPersonArmsComponent(const FObjectInitializer& ObjectInitializer);
+
+	/** How long the arms have to be still with no montage playing before their pose is held */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation | First Person")
+	float StaticSettleTime = 0.5f;
+
+	/** Owner speed under which the arms count as still */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation | First Person")
+	float StaticSpeedTolerance = 1.f;
+
+	/** Plays Montage, unless it is already playing and not yet blending out */
+	void PlayMontageCoalesced(UAnimMontage* Montage, float PlayRate = 1.f);
+
+	/** Returns true while the pose is held instead of evaluated */
+	bool IsPoseHeld() const { return bPoseHeld; }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	float StaticTime = 0.f;
+	bool bPoseHeld = false;
+};
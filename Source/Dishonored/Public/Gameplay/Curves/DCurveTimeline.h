@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCurveFloat;
+
+/**
+ * Fixed step lookup table baked from a UCurveFloat.
+ * Tables are baked once per curve asset and shared by every pawn that plays that curve.
+ */
+struct DISHONORED_API FDBakedCurve
+{
+	/** Samples taken per second of curve time */
+	static constexpr float SamplesPerSecond = 120.f;
+
+	float MinTime = 0.f;
+	float MaxTime = 0.f;
+	float SamplesPerTime = 0.f;
+	TArray<float> Samples;
+
+	/** Linearly interpolates between the two samples either side of Time, clamped to the curve range */
+	float Evaluate(float Time) const;
+
+	/** Returns the shared table for Curve, baking it the first time it is asked for */
+	static TSharedRef<const FDBakedCurve> FindOrBake(const UCurveFloat* Curve);
+};
+
+/**
+ * Minimal replacement for FTimeline that plays a baked curve and calls its
+ * owner back through native delegates instead of UFunction dispatch.
+ * The timeline runs from 0 to Length, 5 seconds unless SetLength is called, like FTimeline's
+ * default TL_TimelineLength. Past the last key the curve holds its last value.
+ */
+class DISHONORED_API FDCurveTimeline
+{
+public:
+	DECLARE_DELEGATE_OneParam(FOnUpdate, float /*CurveValue*/);
+	DECLARE_DELEGATE(FOnFinished);
+
+	/** Called every tick while playing, with the curve value at the new playback position */
+	FOnUpdate OnUpdate;
+	/** Called when playback reaches either end of the timeline */
+	FOnFinished OnFinished;
+
+	void SetCurve(const UCurveFloat* Curve);
+
+	/** Sets how long the timeline plays for, independent of the curve's keys */
+	void SetLength(float NewLength) { Length = FMath::Max(NewLength, 0.f); }
+	float GetLength() const { return Length; }
+
+	void Play();
+	void PlayFromStart();
+	void Reverse();
+	void Stop();
+
+	void Tick(float DeltaTime);
+
+	bool IsPlaying() const { return bPlaying; }
+	float GetPlaybackPosition() const { return Position; }
+
+private:
+	TSharedPtr<const FDBakedCurve> BakedCurve;
+	float Position = 0.f;
+	/** Same default as FTimeline */
+	float Length = 5.f;
+	bool bPlaying = false;
+	bool bReversing = false;
+};
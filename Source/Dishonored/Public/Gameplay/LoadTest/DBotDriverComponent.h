@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DBotDriverComponent.generated.h"
+
+class ADPlayerCharacter;
+class UEnhancedInputLocalPlayerSubsystem;
+
+/**
+ * Drives its player controller's ADPlayerCharacter through a scripted loop of walking, sprinting,
+ * sliding, crouching and firing by injecting the same Enhanced Input actions a player triggers,
+ * so the server sees exactly the traffic a real client produces.
+ * ADPlayerController adds one when the game is launched with -DBot. Run many of them headless
+ * (-nullrhi -nosound) against one server to load test it, see UDServerLoadSubsystem.
+ * Scripts/RunBotLoadTest.sh starts a server, ramps up the bots and writes the resulting curve to a CSV.
+ * The fire phase is skipped until the bot has walked over a weapon pickup.
+ */
+UCLASS()
+class DISHONORED_API UDBotDriverComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDBotDriverComponent();
+
+	/** Whether this process was launched as a load test bot */
+	static bool IsBotClient();
+
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Shortest and longest time spent in each phase of the script */
+	UPROPERTY(EditAnywhere, Category = Bot)
+	FVector2D PhaseDuration = FVector2D(1.5f, 3.f);
+
+	/** Look input applied every frame, so bots circle rather than run into the same wall */
+	UPROPERTY(EditAnywhere, Category = Bot)
+	float TurnInput = 0.5f;
+
+private:
+	enum class EPhase : uint8
+	{
+		Walk,
+		Sprint,
+		Slide,
+		Crouch,
+		Fire,
+		Num
+	};
+
+	void EnterPhase(EPhase NewPhase, ADPlayerCharacter* Character, UEnhancedInputLocalPlayerSubsystem* Input);
+
+	EPhase Phase;
+	float PhaseTimeLeft;
+	float TurnDirection;
+	bool bCrouchToggled;
+	FRandomStream Random;
+};
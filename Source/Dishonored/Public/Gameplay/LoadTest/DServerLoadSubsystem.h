@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DServerLoadSubsystem.generated.h"
+
+/**
+ * Measures how a server copes with the number of players connected to it, for load tests with
+ * UDBotDriverComponent bots. Every server frame the game thread time spent ticking the world
+ * (replication included, the idle wait for the tick rate cap excluded), the part of it spent in
+ * UDReplicationGraph, process CPU use and the bytes sent to each connection are recorded against
+ * the current player count and replicated projectile count.
+ * The resulting players vs. tick time curve is logged by d.Load.Report and when the world ends.
+ */
+UCLASS()
+class DISHONORED_API UDServerLoadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Logs one line per player and projectile count seen so far */
+	void ReportCurve() const;
+
+	/** Forgets everything recorded so far */
+	void ResetSamples();
+
+private:
+	/** Everything recorded while a given number of players was connected */
+	struct FLoadSamples
+	{
+		int32 Frames = 0;
+		double TickMsSum = 0.0;
+		double TickMsMax = 0.0;
+		double ReplicationMsSum = 0.0;
+		double CPUPctSum = 0.0;
+		double OutBytesPerConnectionSum = 0.0;
+		double InBytesPerConnectionSum = 0.0;
+	};
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime);
+	void OnEndFrame();
+
+	/** Samples by player count, then by projectile count rounded down to a multiple of ProjectileBucketSize */
+	TSortedMap<int32, TSortedMap<int32, FLoadSamples>> SamplesByPlayers;
+	uint64 TickStartCycles = 0;
+	double NextPeriodicReportTime = 0.0;
+
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle EndFrameHandle;
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "DReplicationGraph.generated.h"
+
+/** Which graph node a replicated actor is routed to */
+enum class EDClassRepNodeMapping : uint8
+{
+	/** Not in any global node, only replicated by per-connection nodes (player controllers) */
+	NotRouted,
+	/** Replicated to every connection (game state, player states) */
+	RelevantAllConnections,
+	/** Spatialized once where it was added, never moves */
+	Spatialize_Static,
+	/** Spatialized again every frame, for actors that keep moving (pawns, projectiles) */
+	Spatialize_Dynamic,
+	/** Treated as static while dormant and as dynamic while awake (pickups) */
+	Spatialize_Dormancy
+};
+
+/**
+ * Always relevant node for a single connection: its player controller, the pawn it controls
+ * and whatever it is viewing through, so players never lose their own pawn to culling.
+ */
+UCLASS()
+class DISHONORED_API UDReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+/**
+ * Replication graph for the project, set as the net driver's replication driver in DefaultEngine.ini.
+ * Instead of the default net driver considering every replicated actor for every connection each frame,
+ * actors are routed once into nodes: pickups (anything carrying a UTP_PickUpComponent) sit dormant
+ * in the spatial grid until picked up, projectiles and pawns are re-spatialized every frame and culled
+ * by distance, and each connection always gets its own controller and pawn.
+ */
+UCLASS(Transient, config = Engine)
+class DISHONORED_API UDReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	/** Size of a spatial grid cell */
+	UPROPERTY(Config)
+	float GridCellSize = 10000.f;
+
+	/** Lowest world X and Y expected, grid cells start here */
+	UPROPERTY(Config)
+	FVector2D SpatialBias = FVector2D(-150000.f, -150000.f);
+
+	/** Projectiles further than this from a viewer are not sent to it */
+	UPROPERTY(Config)
+	float ProjectileCullDistance = 8000.f;
+
+	virtual void ResetGameWorldState() override;
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/** Game thread time the last ServerReplicateActors took */
+	double GetLastReplicationMs() const { return LastReplicationMs; }
+
+	/** Number of replicated projectiles currently in the graph */
+	int32 GetNumProjectiles() const { return NumProjectiles; }
+
+private:
+	EDClassRepNodeMapping GetMappingPolicy(const AActor* Actor);
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	/** Routing decided the first time an actor of each class is added */
+	TMap<TObjectKey<UClass>, EDClassRepNodeMapping> ClassPolicies;
+
+	double LastReplicationMs = 0.0;
+	int32 NumProjectiles = 0;
+};
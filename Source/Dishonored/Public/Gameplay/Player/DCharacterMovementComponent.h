@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "DCharacterMovementComponent.generated.h"
+
+UENUM(BlueprintType)
+enum EDCustomMovementMode
+{
+	CMOVE_DNone UMETA(Hidden),
+	CMOVE_DMantle
+};
+
+/**
+ * Character movement with the custom movement phases used by ADPlayerCharacter.
+ * Mantling is driven from PhysCustom so it runs inside the regular movement update
+ * instead of overriding velocity from a per frame timeline. The request to mantle is sent with
+ * the saved move (FLAG_Custom_0), so the server starts the same mantle instead of correcting it away.
+ */
+UCLASS()
+class DISHONORED_API UDCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+#pragma region Mantle
+	/** Lowest ledge (above the feet) that is treated as a mantle rather than a step up */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true"))
+	float MantleMinHeight = 50.f;
+
+	/** Highest ledge (above the feet) that can be mantled */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true"))
+	float MantleMaxHeight = 160.f;
+
+	/** How far in front of the capsule we look for a wall */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true"))
+	float MantleReachDistance = 50.f;
+
+	/** Total time taken to climb onto the ledge */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true"))
+	float MantleDuration = 0.4f;
+
+	/** Fraction of the mantle spent rising, the rest is spent moving onto the ledge */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true", ClampMin = "0.1", ClampMax = "0.9"))
+	float MantleRiseFraction = 0.6f;
+
+	/** Distance the capsule has to move before the cached ledge probes are reissued */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true"))
+	float MantleProbeReissueDistance = 10.f;
+
+	/** Yaw change (degrees) before the cached ledge probes are reissued */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Mantle", meta = (AllowPrivateAccess = "true"))
+	float MantleProbeReissueAngle = 5.f;
+#pragma endregion
+
+public:
+	UDCharacterMovementComponent();
+
+	/** Asks for a mantle if there is a climbable ledge in reach, it starts with the next movement update. Returns true if it was asked for */
+	bool TryMantle();
+
+	/** Returns true if there is a climbable ledge in reach, using the cached probes where possible */
+	bool HasMantleLedge();
+
+	UFUNCTION(BlueprintCallable, Category = "Character Movement: Mantle")
+	bool IsMantling() const;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
+private:
+	friend class FSavedMove_DCharacter;
+
+	/** Result of the last set of ledge probes and the state they were issued from */
+	struct FLedgeProbeCache
+	{
+		bool bValid = false;
+		/** The forward probe found a wall, whether or not it could be climbed */
+		bool bHitWall = false;
+		bool bHasLedge = false;
+		FVector ProbeLocation = FVector::ZeroVector;
+		float ProbeYaw = 0.f;
+		float ProbeHalfHeight = 0.f;
+		TWeakObjectPtr<UPrimitiveComponent> FloorComponent;
+		FVector FloorNormal = FVector::UpVector;
+		float FloorZ = 0.f;
+		FVector MantleTarget = FVector::ZeroVector;
+	};
+
+	/** Returns true if we are in a state a mantle can start from at all */
+	bool CanProbeForLedge() const;
+	bool ShouldReissueLedgeProbes() const;
+	void IssueLedgeProbes();
+	void StartMantle();
+	void PhysMantle(float deltaTime, int32 Iterations);
+
+	FLedgeProbeCache LedgeProbeCache;
+	/** Set by TryMantle (or a client's saved move on the server) until the next movement update starts the mantle */
+	bool bWantsToMantle;
+	FVector MantleStart;
+	FVector MantleTarget;
+	float MantleElapsed;
+};
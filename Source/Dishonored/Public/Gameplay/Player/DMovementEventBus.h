@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Gameplay/Player/DPlayerCharacter.h"
+#include "DMovementEventBus.generated.h"
+
+/**
+ * Native, typed movement state notifications for every ADPlayerCharacter in the world.
+ * Characters queue their EMovementState transitions here and the bus delivers them once
+ * per frame, so toggling back and forth inside a frame becomes a single notification
+ * (or none, if the character ended up where it started).
+ * C++ listeners (HUD, audio, AI hearing, analytics) bind to OnMovementStateChanged directly,
+ * Blueprints keep using the delegates on ADPlayerCharacter which are fired from the same flush.
+ */
+UCLASS()
+class DISHONORED_API UDMovementEventBus : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnMovementStateChanged, ADPlayerCharacter* /*Character*/, EMovementState /*PreviousState*/, EMovementState /*NewState*/);
+
+	/** Fired once per frame per character whose movement state changed */
+	FOnMovementStateChanged OnMovementStateChanged;
+
+	/** Records a transition to be delivered at the end of this frame. Queue one to the same state to flush a crouch change */
+	void QueueTransition(ADPlayerCharacter* Character, EMovementState PreviousState, EMovementState NewState);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return PendingTransitions.Num() > 0; }
+
+private:
+	struct FPendingTransition
+	{
+		TWeakObjectPtr<ADPlayerCharacter> Character;
+		/** State at the start of the frame */
+		EMovementState FromState;
+		/** Latest state this frame */
+		EMovementState ToState;
+	};
+
+	TArray<FPendingTransition> PendingTransitions;
+};
@@ -4,7 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
-#include "Components/TimelineComponent.h"
+#include "Perception/AISightTargetInterface.h"
+#include "Gameplay/Curves/DCurveTimeline.h"
+#include "Gameplay/Simulation/DFixedStepSubsystem.h"
+#include "Gameplay/Player/DPrebindInputPawn.h"
 #include "DPlayerCharacter.generated.h"
 
 class UInputComponent;
@@ -13,8 +16,7 @@ class UCameraComponent;
 class UInputAction;
 class UInputMappingContext;
 struct FInputActionValue;
-class UTimelineComponent;
-class FOnTimelineEvent;
+class UDCharacterMovementComponent;
 struct FTimerHandle;
 
 UENUM(BlueprintType)
@@ -27,9 +29,10 @@ enum EMovementState
 };
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCrouchChangedSignature, bool, isCrouching);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMovementStateChangedSignature, TEnumAsByte<EMovementState>, PreviousState, TEnumAsByte<EMovementState>, NewState);
 
 UCLASS()
-class DISHONORED_API ADPlayerCharacter : public ACharacter
+class DISHONORED_API ADPlayerCharacter : public ACharacter, public IAISightTargetInterface, public IDFixedStepActor, public IDPrebindInputPawn
 {
 	GENERATED_BODY()
 
@@ -63,6 +66,18 @@ class DISHONORED_API ADPlayerCharacter : public ACharacter
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	UInputAction* SprintAction;
+
+	/** Bend Time Input Action */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
+	UInputAction* BendTimeAction;
+
+	/** Possession Input Action */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
+	UInputAction* PossessAction;
+
+	/** Lean Input Action, axis from -1 (left) to 1 (right) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
+	UInputAction* LeanAction;
 #pragma endregion
 
 
@@ -85,19 +100,51 @@ class DISHONORED_API ADPlayerCharacter : public ACharacter
 	UCurveFloat* CameraTiltCurve;
 	UPROPERTY(EditAnywhere, Category = "Movement | Slide", meta = (AllowPrivateAccess = "true"))
 	UCurveFloat* SlideCurve;
-	
+	/** How long the slide and camera tilt timelines play for. The slide ends when it runs out, whatever the curves' length */
+	UPROPERTY(EditAnywhere, Category = "Movement | Slide", meta = (AllowPrivateAccess = "true"))
+	float TimelineLength = 5.f;
+
+
+	/** How far the camera moves sideways at full lean */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement | Lean", meta = (AllowPrivateAccess = "true"))
+	float LeanDistance = 45.f;
+	/** Camera roll at full lean */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement | Lean", meta = (AllowPrivateAccess = "true"))
+	float LeanRoll = 12.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement | Lean", meta = (AllowPrivateAccess = "true"))
+	float LeanInterpSpeed = 10.f;
+	/** Radius of the sweep used to keep the leaning camera out of walls */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement | Lean", meta = (AllowPrivateAccess = "true"))
+	float LeanProbeRadius = 12.f;
+
+
+	/** How long Bend Time stops time for */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Powers | Bend Time", meta = (AllowPrivateAccess = "true"))
+	float BendTimeDuration = 5.f;
+
+	/** How far away a pawn can be possessed from */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Powers | Possession", meta = (AllowPrivateAccess = "true"))
+	float PossessRange = 1500.f;
+
 
 public:
 	// Sets default values for this character's properties
-	ADPlayerCharacter();
+	ADPlayerCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
+	// Called to work out the view from this pawn
+	virtual void CalcCamera(float DeltaTime, struct FMinimalViewInfo& OutResult) override;
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+	// Called when a controller stops possessing us
+	virtual void DestroyPlayerInputComponent() override;
+	// Called when the capsule has actually shrunk or grown back
+	virtual void OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
+	virtual void OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
 
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
@@ -105,38 +152,101 @@ protected:
 	/** Called for looking input */
 	void Look(const FInputActionValue& Value);
 
+	/** Mantles onto a ledge in front of us if there is one, otherwise jumps */
+	void JumpOrMantle();
+
+	/** Called for lean input */
+	void Lean(const FInputActionValue& Value);
+	void StopLeaning();
+
+	/** Stops time, or restarts it early if it is already stopped */
+	void ToggleBendTime();
+	void EndBendTime();
+
+	/** Possesses the pawn we are looking at, or returns to our own body if we are already possessing one */
+	void TryPossess();
+
 	void DetermineCrouchOrSlide();
 	void ToggleCrouch();
 	void StartSliding();
-	UFUNCTION()
 	void StopSliding();
 
 	void StartSprinting();
 	void StopSprinting();
 
-	
-	UFUNCTION()
-	void TiltCamera();
 
-	UFUNCTION()
-	void SlidePlayer();
+	void TiltCamera(float CurveFloatValue);
+	void SlidePlayer(float CurveFloatValue);
 
 
 private:
 	FTimerHandle SlideTimerHandle;
+	FTimerHandle BendTimeTimerHandle;
 	float StandingHalfHeight;
 	EMovementState MovementState;
-	FTimeline CameraTiltTimeline;
-	FTimeline SlideTimeline;
+	FDCurveTimeline CameraTiltTimeline;
+	FDCurveTimeline SlideTimeline;
 	float StandingZOffset;
 
+	float LeanInput;
+	/** Current lean from -1 (full left) to 1 (full right) */
+	float LeanAlpha;
+	float StandingYOffset;
+	float SlideTiltRoll;
+
+	/** True when UDFixedStepSubsystem is advancing our movement instead of Tick */
+	bool bFixedStepSimulation;
+	/** Movement input from the last frame, replayed for every fixed step until the next one */
+	FVector FixedStepMovementInput;
+	FVector PresentationOffset;
+	/** Crouch state last sent to OnCrouchChangedDelegate */
+	bool bNotifiedCrouched;
+
 	bool ShouldConsiderMoveInput();
+	/** Returns true if a player on this machine could end up controlling us */
+	bool CanBeLocallyPossessed() const;
+	/** Changes MovementState and queues the transition on the movement event bus */
+	void SetMovementState(EMovementState NewState);
+	void UpdateLean(float DeltaTime);
+	/** Combines the slide tilt and lean roll into the control rotation */
+	void ApplyCameraRoll();
 public:	
 	/** Returns Mesh1P subobject **/
 	USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
 	/** Returns FirstPersonCameraComponent subobject **/
 	UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
+	/** Returns CharacterMovement as our movement component **/
+	UDCharacterMovementComponent* GetDCharacterMovement() const;
+	/** Returns where our head currently is, including any lean **/
+	FVector GetExposedHeadLocation() const;
+	/** Returns the input actions, so load test bots can press them like a player **/
+	const UInputAction* GetMoveAction() const { return MoveAction; }
+	const UInputAction* GetLookAction() const { return LookAction; }
+	const UInputAction* GetCrouchAction() const { return CrouchAction; }
+	const UInputAction* GetSprintAction() const { return SprintAction; }
+	/** Returns how lit we are, from 0 (dark) to 1 (fully lit) **/
+	UFUNCTION(BlueprintCallable, Category = Stealth)
+	float GetLightExposure() const;
+
+	// IDFixedStepActor
+	virtual void FixedStep(float StepDelta) override;
+	virtual void HashFixedStepState(uint32& InOutHash) const override;
+	virtual void SetPresentationOffset(const FVector& Offset) override;
+
+	// IDPrebindInputPawn
+	virtual void PrebindInput() override;
+
+	// IAISightTargetInterface
+	virtual UAISense_Sight::EVisibilityResult CanBeSeenFrom(const FCanBeSeenFromContext& Context, FVector& OutSeenLocation, int32& OutNumberOfLoSChecksPerformed, int32& OutNumberOfAsyncLosCheckRequested, float& OutSightStrength, int32* UserData = nullptr, const FOnPendingVisibilityQueryProcessedDelegate* Delegate = nullptr) override;
+
+	/** Called by UDMovementEventBus once per frame with the coalesced transition. Fires the Blueprint delegates */
+	void NotifyMovementStateChanged(EMovementState PreviousState, EMovementState NewState);
+	/** Called by UDMovementEventBus in the same flush. Fires OnCrouchChangedDelegate if bIsCrouched ended the frame different from last time */
+	void NotifyCrouchChanged();
 
 	UPROPERTY(BlueprintAssignable)
 	FOnCrouchChangedSignature OnCrouchChangedDelegate;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnMovementStateChangedSignature OnMovementStateChangedDelegate;
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "UObject/ObjectKey.h"
 #include "DPlayerController.generated.h"
 
 class UInputMappingContext;
@@ -30,10 +31,73 @@ protected:
 	UPROPERTY()
 	TObjectPtr<UUserWidget> HUD;
 
+	/** How long Possession lasts before we are sent back to our own body */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Powers | Possession")
+	float PossessionDuration = 10.f;
+
+	/** How long the camera takes to move between bodies */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Powers | Possession")
+	float PossessionBlendTime = 0.35f;
+
+public:
+	/** Takes control of Target, returning to our own body after PossessionDuration. Returns false if Target can't be possessed.
+	 *  On a client this only sends the request, the server does the swap */
+	bool BeginPossession(APawn* Target);
+
+	/** Returns control to the body we possessed from. On a client this asks the server to */
+	void EndPossession();
+
+	bool IsPossessing() const { return OwnBody.IsValid(); }
+
+	/**
+	 * Moves control to NewPawn on this frame without re-creating the HUD, the mapping contexts or the pawn's
+	 * input bindings, blending the camera from the old pawn. Whatever was controlling NewPawn gets it back
+	 * when we leave it again
+	 */
+	void SwapPawn(APawn* NewPawn);
+
+	/** Returns true if Component is on the input stack built for this frame, i.e. it is receiving input */
+	bool IsReceivingInput(const UInputComponent* Component) const;
+
 	// Begin Actor interface
 protected:
 
 	virtual void BeginPlay() override;
 
 	// End Actor interface
+
+	virtual void PlayerTick(float DeltaTime) override;
+
+	virtual void BuildInputStack(TArray<UInputComponent*>& InputStack) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+private:
+	UFUNCTION(Server, Reliable)
+	void ServerBeginPossession(APawn* Target);
+
+	UFUNCTION(Server, Reliable)
+	void ServerEndPossession();
+
+	/** Checks everything BeginPossession can check locally */
+	bool CanPossess(const APawn* Target) const;
+
+	/** The body we left to possess someone, unset while not possessing. Replicated so the owning client knows it is possessing */
+	UPROPERTY(Replicated)
+	TWeakObjectPtr<APawn> OwnBody;
+
+	/** Controllers we took a pawn from, by pawn */
+	TMap<TObjectKey<APawn>, TWeakObjectPtr<AController>> DisplacedControllers;
+
+	FTimerHandle PossessionTimerHandle;
+
+	/** Running average frame time, to judge the swap frame against */
+	float AverageFrameMs = 0.f;
+	/** The input components input was last routed to, the pawn's included */
+	TArray<TWeakObjectPtr<UInputComponent>> LastInputStack;
+
+	/** How long the last SwapPawn call took, set until the frame it happened on has been measured */
+	double PendingSwapMs = -1.0;
+	/** GFrameCounter on the frame of the last swap */
+	uint64 SwapFrame = 0;
 };
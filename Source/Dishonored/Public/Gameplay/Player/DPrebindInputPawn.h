@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "DPrebindInputPawn.generated.h"
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UDPrebindInputPawn : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Pawns that can build their input bindings before they are possessed and keep them between
+ * possessions, so ADPlayerController::SwapPawn doesn't pay for SetupPlayerInputComponent.
+ * Building the input component needs APawn's protected hooks, so each pawn class implements it
+ * (see ADPlayerCharacter). Any other pawn can still be possessed, it just binds its input on the swap frame.
+ */
+class DISHONORED_API IDPrebindInputPawn
+{
+	GENERATED_BODY()
+
+public:
+	/** Creates and binds the player input component now if there isn't one yet */
+	virtual void PrebindInput() = 0;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "DTimeControlSubsystem.generated.h"
+
+class UActorComponent;
+
+/**
+ * Stops time for everything except the caster, for Bend Time.
+ * Instead of dilating time (which still ticks every actor, movement component and physics body
+ * at a tiny delta) affected actors have their ticks switched off and their physics simulation
+ * suspended. Velocities and remaining life spans are stored and put back exactly on resume,
+ * so a frozen world costs less than a running one.
+ */
+UCLASS()
+class DISHONORED_API UDTimeControlSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/** Freezes every movable actor in the world apart from Caster and anything attached to it */
+	void StopTime(AActor* Caster);
+
+	/** Unfreezes everything frozen by StopTime, restoring velocities */
+	void ResumeTime();
+
+	UFUNCTION(BlueprintCallable, Category = "Time Control")
+	bool IsTimeStopped() const { return bTimeStopped; }
+
+	/** Returns true if Actor is currently frozen by StopTime */
+	bool IsActorFrozen(const AActor* Actor) const { return FrozenActorKeys.Contains(Actor); }
+
+private:
+	struct FFrozenComponent
+	{
+		TWeakObjectPtr<UActorComponent> Component;
+		bool bTickEnabled = false;
+		bool bSimulatingPhysics = false;
+		FVector LinearVelocity = FVector::ZeroVector;
+		FVector AngularVelocity = FVector::ZeroVector;
+		FVector MovementVelocity = FVector::ZeroVector;
+	};
+
+	struct FFrozenActor
+	{
+		TWeakObjectPtr<AActor> Actor;
+		bool bTickEnabled = false;
+		float RemainingLifeSpan = 0.f;
+		TArray<FFrozenComponent> Components;
+	};
+
+	bool ShouldFreeze(const AActor* Actor) const;
+	void FreezeActor(AActor* Actor);
+	void ThawActor(FFrozenActor& Frozen);
+	void OnActorSpawned(AActor* Actor);
+
+	bool bTimeStopped = false;
+	TSet<TObjectKey<AActor>> ExemptActors;
+	TArray<FFrozenActor> FrozenActors;
+	TSet<TObjectKey<AActor>> FrozenActorKeys;
+	FDelegateHandle ActorSpawnedHandle;
+};
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/Interface.h"
+#include "DFixedStepSubsystem.generated.h"
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UDFixedStepActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Actors whose gameplay simulation is advanced by UDFixedStepSubsystem instead of their own tick
+ * while fixed step mode is on.
+ */
+class DISHONORED_API IDFixedStepActor
+{
+	GENERATED_BODY()
+
+public:
+	/** Advances the simulation by exactly StepDelta seconds */
+	virtual void FixedStep(float StepDelta) = 0;
+
+	/** Mixes everything that should be identical between two runs of the same step into InOutHash */
+	virtual void HashFixedStepState(uint32& InOutHash) const = 0;
+
+	/** Offsets how the actor is drawn so it sits between its last two simulated positions */
+	virtual void SetPresentationOffset(const FVector& Offset) = 0;
+};
+
+/**
+ * Opt-in fixed timestep gameplay simulation, turned on with d.FixedStep.Enable before the level starts.
+ * Each frame the elapsed time is accumulated and registered actors are advanced in whole steps of
+ * 1 / d.FixedStep.Rate seconds, several per frame when the frame was long. When the frame was shorter
+ * than a step, actors are drawn interpolated between their last two steps.
+ * After every step the state of every registered actor is hashed, so two runs can be compared
+ * with d.FixedStep.SaveHashes and d.FixedStep.CompareHashes.
+ */
+UCLASS()
+class DISHONORED_API UDFixedStepSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Whether actors starting play now should hand their simulation to this subsystem */
+	static bool IsFixedStepEnabled();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Starts stepping Actor, which must implement IDFixedStepActor */
+	void RegisterActor(AActor* Actor);
+
+	float GetStepDelta() const;
+	int64 GetStepIndex() const { return StepIndex; }
+	const TArray<uint32>& GetStepHashes() const { return StepHashes; }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Participants.Num() > 0; }
+
+private:
+	struct FParticipant
+	{
+		TWeakObjectPtr<AActor> Actor;
+		IDFixedStepActor* Stepped;
+		FVector PreviousLocation;
+	};
+
+	void RunStep(float StepDelta);
+
+	TArray<FParticipant> Participants;
+	float Accumulator = 0.f;
+	int64 StepIndex = 0;
+	TArray<uint32> StepHashes;
+};
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "DStartupTimingSubsystem.generated.h"
+
+/**
+ * Times the load phases between process launch and the first controllable frame: game instance
+ * start, map load, player controller and character BeginPlay, World Partition streaming and the
+ * first frame where a local controller possesses an ADPlayerCharacter with its input bound.
+ * Every phase is also a trace bookmark, so it lines up with the CPU scopes in Unreal Insights.
+ * The breakdown is logged once the game is playable. Launched with -DStartupBenchmark the run is
+ * appended to Saved/Startup/StartupTimes.txt, the median and standard deviation of every phase over
+ * the last 10 recorded runs (-DStartupBenchmarkWindow=<runs>, 0 for all) are logged, and the game exits,
+ * failing when -DStartupBudgetMs=<ms> is exceeded.
+ */
+UCLASS()
+class DISHONORED_API UDStartupTimingSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Records that Phase first finished now, relative to process launch. Ignored once the game is playable */
+	void MarkPhase(const TCHAR* Phase);
+
+	bool IsPlayable() const { return bPlayable; }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return !bPlayable; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+
+private:
+	struct FPhase
+	{
+		FString Name;
+		/** Seconds since process launch */
+		double Time;
+	};
+
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostLoadMap(UWorld* LoadedWorld);
+	void ReportPhases() const;
+	void RecordBenchmarkRun() const;
+
+	TArray<FPhase> Phases;
+	bool bWorldStreamed = false;
+	bool bPlayable = false;
+
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PostLoadMapHandle;
+};
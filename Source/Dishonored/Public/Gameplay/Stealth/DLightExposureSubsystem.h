@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "DLightExposureSubsystem.generated.h"
+
+class ACharacter;
+class ULightComponent;
+class ULevel;
+
+/**
+ * Estimates how lit characters are for stealth, entirely on the CPU so it also runs on
+ * dedicated servers and -nullrhi test runs.
+ * Lights are kept in a uniform grid by their attenuation radius. A character is sampled at
+ * its feet, middle and head (using its current capsule, so crouching and sliding count) and
+ * each sample adds up the in-range lights it has line of sight to.
+ * Exposure is only recomputed when the character or a light near it moves or goes away, and the
+ * number of occlusion traces per frame is capped by d.LightExposure.TraceBudget. A subject that
+ * runs out of budget part way through keeps its place and carries on next frame.
+ */
+UCLASS()
+class DISHONORED_API UDLightExposureSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Starts tracking the light exposure of Character */
+	void RegisterCharacter(ACharacter* Character);
+
+	/** Adds a light created after the level was indexed, lights placed in levels are picked up automatically */
+	void RegisterLight(ULightComponent* Light);
+
+	/** Returns the last computed exposure for Character, from 0 (dark) to 1 (fully lit) */
+	float GetLightExposure(const ACharacter* Character) const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FLightEntry
+	{
+		TWeakObjectPtr<ULightComponent> Light;
+		FVector Location;
+		FVector Direction;
+		float Radius;
+		float CosOuterCone;
+		bool bDirectional;
+		TArray<FIntVector> Cells;
+	};
+
+	struct FSubject
+	{
+		TWeakObjectPtr<ACharacter> Character;
+		FVector SampledLocation;
+		float SampledHalfHeight;
+		bool bDirty;
+		float Exposure;
+
+		/** Set while an evaluation is spread over several frames */
+		bool bSampling = false;
+		/** Feet, middle and head when the evaluation started */
+		FVector SamplePoints[3];
+		int32 PointIndex = 0;
+		/** Next light to check for the current point, counting cell lights, then large, then directional ones */
+		int32 LightCursor = 0;
+		float PointExposure = 0.f;
+		float PendingExposure = 0.f;
+	};
+
+	void IndexLevel(ULevel* Level);
+	void UpdateLightCells(int32 LightIndex);
+	void RemoveLight(int32 LightIndex);
+	/** Marks everyone Entry could be lighting for resampling */
+	void DirtySubjectsLitBy(const FLightEntry& Entry);
+	/** Drops a few lights per frame whose component has been destroyed or unregistered */
+	void SweepDeadLights();
+	void OnLevelAdded(ULevel* Level, UWorld* InWorld);
+	void OnLevelRemoved(ULevel* Level, UWorld* InWorld);
+	void OnLightTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	void BeginSample(FSubject& Subject);
+	/** Carries on evaluating Subject until it is done or InOutTraces reaches TraceBudget. Returns true when done */
+	bool ContinueSample(FSubject& Subject, int32& InOutTraces, int32 TraceBudget);
+	/** Adds the light at LightIndex to Subject's current point. Returns false, without tracing, if that would need a trace past TraceBudget */
+	bool AddLight(FSubject& Subject, int32 LightIndex, int32& InOutTraces, int32 TraceBudget);
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	TSparseArray<FLightEntry> Lights;
+	TMap<TObjectKey<ULightComponent>, int32> LightIndices;
+	TMap<FIntVector, TArray<int32>> LightGrid;
+	TArray<int32> DirectionalLights;
+	/** Lights too big to be worth putting in the grid */
+	TArray<int32> LargeLights;
+
+	TArray<FSubject> Subjects;
+	int32 NextSubject = 0;
+	/** Where SweepDeadLights carries on from */
+	int32 NextSweptLight = 0;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "DBallisticTraceSubsystem.generated.h"
+
+class UTP_WeaponComponent;
+
+/**
+ * Flies trace based shots (bolts, pistol rounds) along ballistic arcs without spawning actors.
+ * Every frame each shot in flight submits one async line trace for the part of the arc it covers
+ * that frame. The engine batches all of them into a few trace jobs and the results come back
+ * on the next frame, where hits go through ADishonoredProjectile::ApplyImpact like a projectile hit.
+ */
+UCLASS()
+class DISHONORED_API UDBallisticTraceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/**
+	 * Starts a shot at Location moving with Velocity, affected by GravityZ, that gives up after MaxFlightTime.
+	 * A cosmetic shot only plays its impact sound, for a client's own copy of a shot the server is flying
+	 */
+	void FireShot(const FVector& Location, const FVector& Velocity, float GravityZ, float MaxFlightTime, AActor* Instigator, UTP_WeaponComponent* Weapon = nullptr, bool bCosmetic = false);
+
+	int32 GetNumShotsInFlight() const { return Shots.Num(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Shots.Num() > 0; }
+
+private:
+	struct FShot
+	{
+		FVector Location;
+		FVector Velocity;
+		float GravityZ;
+		float FlightTime;
+		float MaxFlightTime;
+		TWeakObjectPtr<AActor> Instigator;
+		/** Weapon that fired the shot, plays the impact sound */
+		TWeakObjectPtr<UTP_WeaponComponent> Weapon;
+		/** Leaves impacts to the server's copy of the shot */
+		bool bCosmetic = false;
+
+		/** End of the segment currently being traced */
+		bool bTracePending = false;
+		FVector SegmentEnd;
+		FVector SegmentEndVelocity;
+		float SegmentTime;
+	};
+
+	void OnSegmentTraced(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	TMap<uint32, FShot> Shots;
+	uint32 NextShotId = 0;
+	FTraceDelegate SegmentTracedDelegate;
+};
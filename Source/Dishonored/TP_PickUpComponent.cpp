@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "TP_PickUpComponent.h"
+#include "TP_WeaponComponent.h"
 
 UTP_PickUpComponent::UTP_PickUpComponent()
 {
@@ -14,14 +15,27 @@ void UTP_PickUpComponent::BeginPlay()
 
 	// Register our Overlap Event
 	OnComponentBeginOverlap.AddDynamic(this, &UTP_PickUpComponent::OnSphereBeginOverlap);
+
+	// Nothing about a pickup changes until it is picked up, so the server stops considering it until then
+	AActor* Owner = GetOwner();
+	if (Owner->HasAuthority() && Owner->GetIsReplicated())
+	{
+		Owner->SetNetDormancy(DORM_DormantAll);
+	}
 }
 
 void UTP_PickUpComponent::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
 	// Checking if it is a First Person Character overlapping
-	ADishonoredCharacter* Character = Cast<ADishonoredCharacter>(OtherActor);
-	if(Character != nullptr)
+	ACharacter* Character = Cast<ACharacter>(OtherActor);
+	if(Character != nullptr && UTP_WeaponComponent::GetFirstPersonMesh(Character) != nullptr)
 	{
+		// Wake up so clients see the pickup being taken
+		if (GetOwner()->HasAuthority())
+		{
+			GetOwner()->SetNetDormancy(DORM_Awake);
+		}
+
 		// Notify that the actor is being picked up
 		OnPickUp.Broadcast(Character);
 
@@ -3,21 +3,61 @@
 
 #include "TP_WeaponComponent.h"
 #include "DishonoredCharacter.h"
+#include "Gameplay/Player/DPlayerCharacter.h"
 #include "DishonoredProjectile.h"
+#include "Gameplay/Weapons/DBallisticTraceSubsystem.h"
+#include "Gameplay/Animation/DFirstPersonArmsComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "Camera/PlayerCameraManager.h"
-#include "Kismet/GameplayStatics.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "Animation/AnimInstance.h"
+#include "Components/AudioComponent.h"
+#include "Dishonored.h"
 #include "Engine/LocalPlayer.h"
 #include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Voices Played"), STAT_DWeaponVoicesPlayed, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Voices Stolen"), STAT_DWeaponVoicesStolen, STATGROUP_Dishonored);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Voices Culled"), STAT_DWeaponVoicesCulled, STATGROUP_Dishonored);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon Voices Allocated"), STAT_DWeaponVoicesAllocated, STATGROUP_Dishonored);
+
+namespace DWeaponFire
+{
+	/** How far a client's muzzle may be from where the server puts it, covers movement the server hasn't seen yet */
+	constexpr float MaxMuzzleError = 150.f;
+	/** How far a client's aim may be from the server's view of its control rotation, in degrees */
+	constexpr float MaxAimError = 15.f;
+
+	static FAutoConsoleCommandWithWorldAndArgs AudioBenchmarkCommand(
+		TEXT("d.Weapon.AudioBenchmark"),
+		TEXT("d.Weapon.AudioBenchmark [Shots=1000]: plays fire sounds around the listener through every weapon and logs voices, culls and time taken. Runs under -nosound"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const int32 NumShots = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+			UTP_WeaponComponent::RunAudioBenchmark(World, FMath::Max(NumShots, 1));
+		}));
+}
 
 // Sets default values for this component's properties
 UTP_WeaponComponent::UTP_WeaponComponent()
 {
 	// Default offset from the character location for projectiles to spawn
 	MuzzleOffset = FVector(100.0f, 0.0f, 10.0f);
+
+	// Traced shots default to the same flight as the template projectile
+	FireMode = EWeaponFireMode::Projectile;
+	BallisticSpeed = 3000.f;
+	BallisticGravityScale = 1.f;
+	BallisticMaxFlightTime = 3.f;
+
+	MaxVoices = 4;
+	AudibleDistance = 5000.f;
+
+	// Clients send their shots to the server through us
+	SetIsReplicatedByDefault(true);
 }
 
 
@@ -28,68 +68,284 @@ void UTP_WeaponComponent::Fire()
 		return;
 	}
 
-	// Try and fire a projectile
-	if (ProjectileClass != nullptr)
+	APlayerController* PlayerController = Cast<APlayerController>(Character->GetController());
+	if (PlayerController != nullptr && PlayerController->PlayerCameraManager != nullptr)
 	{
-		UWorld* const World = GetWorld();
-		if (World != nullptr)
+		const FRotator SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+		// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+		const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
+
+		// The server owns the shot, a client's own copy of a traced shot is only there for feedback
+		if (!Character->HasAuthority())
 		{
-			APlayerController* PlayerController = Cast<APlayerController>(Character->GetController());
-			const FRotator SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
-			// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-			const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
-	
-			//Set Spawn Collision Handling Override
-			FActorSpawnParameters ActorSpawnParams;
-			ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
-	
-			// Spawn the projectile at the muzzle
-			World->SpawnActor<ADishonoredProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+			ServerFire(SpawnLocation, SpawnRotation);
 		}
+		SpawnShot(SpawnLocation, SpawnRotation);
 	}
 	
 	// Try and play the sound if specified
-	if (FireSound != nullptr)
-	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, Character->GetActorLocation());
-	}
+	PlayPooledSound(FireSound, Character->GetActorLocation());
 	
 	// Try and play a firing animation if specified
 	if (FireAnimation != nullptr)
 	{
+		// Fire triggers every frame while held, let the arms coalesce that instead of restarting the montage each time
+		USkeletalMeshComponent* Mesh1P = GetFirstPersonMesh(Character);
+		if (UDFirstPersonArmsComponent* Arms = Cast<UDFirstPersonArmsComponent>(Mesh1P))
+		{
+			Arms->PlayMontageCoalesced(FireAnimation);
+		}
 		// Get the animation object for the arms mesh
-		UAnimInstance* AnimInstance = Character->GetMesh1P()->GetAnimInstance();
-		if (AnimInstance != nullptr)
+		else if (UAnimInstance* AnimInstance = Mesh1P ? Mesh1P->GetAnimInstance() : nullptr)
 		{
 			AnimInstance->Montage_Play(FireAnimation, 1.f);
 		}
 	}
 }
 
-bool UTP_WeaponComponent::AttachWeapon(ADishonoredCharacter* TargetCharacter)
+void UTP_WeaponComponent::SpawnShot(const FVector& SpawnLocation, const FRotator& SpawnRotation)
 {
-	Character = TargetCharacter;
+	UWorld* const World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	if (FireMode == EWeaponFireMode::BallisticTrace)
+	{
+		// Fly a traced shot, no actor is spawned
+		if (UDBallisticTraceSubsystem* BallisticTraces = World->GetSubsystem<UDBallisticTraceSubsystem>())
+		{
+			BallisticTraces->FireShot(SpawnLocation, SpawnRotation.Vector() * BallisticSpeed, World->GetGravityZ() * BallisticGravityScale, BallisticMaxFlightTime, Character, this, !Character->HasAuthority());
+		}
+	}
+	// Try and fire a projectile, clients get it replicated from the server
+	else if (ProjectileClass != nullptr && Character->HasAuthority())
+	{
+		//Set Spawn Collision Handling Override
+		FActorSpawnParameters ActorSpawnParams;
+		ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+		// Spawn the projectile at the muzzle
+		if (ADishonoredProjectile* Projectile = World->SpawnActor<ADishonoredProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams))
+		{
+			Projectile->SetSourceWeapon(this);
+		}
+	}
+}
+
+void UTP_WeaponComponent::ServerFire_Implementation(FVector_NetQuantize SpawnLocation, FRotator SpawnRotation)
+{
+	// Shots from someone who isn't holding us are ignored
+	if (Character == nullptr || Character->GetController() == nullptr)
+	{
+		return;
+	}
+
+	// Trust the client's aim only as far as it agrees with what we know of its pawn
+	const FRotator ViewRotation = Character->GetControlRotation();
+	FRotator Rotation = SpawnRotation;
+	const float AimError = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(Rotation.Vector() | ViewRotation.Vector(), -1.f, 1.f)));
+	if (AimError > DWeaponFire::MaxAimError)
+	{
+		Rotation = ViewRotation;
+	}
+
+	const FVector ExpectedLocation = GetOwner()->GetActorLocation() + Rotation.RotateVector(MuzzleOffset);
+	const FVector Location = ExpectedLocation + (FVector(SpawnLocation) - ExpectedLocation).GetClampedToMaxSize(DWeaponFire::MaxMuzzleError);
+
+	SpawnShot(Location, Rotation);
+}
+
+void UTP_WeaponComponent::PlayImpactSound(const FVector& Location)
+{
+	PlayPooledSound(ImpactSound, Location);
+}
+
+void UTP_WeaponComponent::PlayPooledSound(USoundBase* Sound, const FVector& Location)
+{
+	UWorld* const World = GetWorld();
+	if (Sound == nullptr || World == nullptr)
+	{
+		return;
+	}
+
+	// Cull before we take a voice, nobody to hear it means nothing to play (dedicated servers included)
+	if (!IsAudibleLocally(Location))
+	{
+		TotalVoicesCulled++;
+		INC_DWORD_STAT(STAT_DWeaponVoicesCulled);
+		return;
+	}
+
+	// Prefer an idle voice, then a new one while under budget, then steal the oldest
+	int32 VoiceIndex = Voices.IndexOfByPredicate([](const UAudioComponent* Voice) { return !Voice->IsPlaying(); });
+	if (VoiceIndex == INDEX_NONE && Voices.Num() < MaxVoices)
+	{
+		UAudioComponent* Voice = NewObject<UAudioComponent>(GetOwner());
+		Voice->bAutoActivate = false;
+		Voice->bAutoDestroy = false;
+		Voice->RegisterComponent();
+		VoiceIndex = Voices.Add(Voice);
+		VoiceStartTimes.Add(0.0);
+		INC_DWORD_STAT(STAT_DWeaponVoicesAllocated);
+	}
+	if (VoiceIndex == INDEX_NONE)
+	{
+		VoiceIndex = 0;
+		for (int32 Index = 1; Index < VoiceStartTimes.Num(); ++Index)
+		{
+			if (VoiceStartTimes[Index] < VoiceStartTimes[VoiceIndex])
+			{
+				VoiceIndex = Index;
+			}
+		}
+		Voices[VoiceIndex]->Stop();
+		TotalVoicesStolen++;
+		INC_DWORD_STAT(STAT_DWeaponVoicesStolen);
+	}
+
+	UAudioComponent* Voice = Voices[VoiceIndex];
+	Voice->SetWorldLocation(Location);
+	Voice->SetSound(Sound);
+	Voice->Play();
+	VoiceStartTimes[VoiceIndex] = World->GetTimeSeconds();
+	TotalVoicesPlayed++;
+	INC_DWORD_STAT(STAT_DWeaponVoicesPlayed);
+}
+
+bool UTP_WeaponComponent::IsAudibleLocally(const FVector& Location) const
+{
+	const float AudibleDistanceSquared = FMath::Square(AudibleDistance);
+	FVector ListenerLocation, ListenerFront, ListenerRight;
+
+	// Our holder's own listener is the one that hears almost everything we play
+	const APlayerController* OwningController = Character != nullptr ? Cast<APlayerController>(Character->GetController()) : nullptr;
+	if (OwningController != nullptr && OwningController->IsLocalController())
+	{
+		OwningController->GetAudioListenerPosition(ListenerLocation, ListenerFront, ListenerRight);
+		if (FVector::DistSquared(ListenerLocation, Location) <= AudibleDistanceSquared) { return true; }
+	}
+
+	// Remote and AI holders, or another split-screen player standing closer
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* Controller = It->Get();
+		if (Controller == nullptr || Controller == OwningController || !Controller->IsLocalController()) { continue; }
+
+		Controller->GetAudioListenerPosition(ListenerLocation, ListenerFront, ListenerRight);
+		if (FVector::DistSquared(ListenerLocation, Location) <= AudibleDistanceSquared) { return true; }
+	}
+	return false;
+}
+
+void UTP_WeaponComponent::RunAudioBenchmark(UWorld* World, int32 NumShots)
+{
+	if (World == nullptr) { return; }
+
+	TArray<UTP_WeaponComponent*> Weapons;
+	for (TObjectIterator<UTP_WeaponComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == World && It->FireSound != nullptr && !It->IsTemplate())
+		{
+			Weapons.Add(*It);
+		}
+	}
+	if (Weapons.Num() == 0)
+	{
+		UE_LOG(LogDishonored, Warning, TEXT("Weapon audio benchmark: no weapons with a fire sound in this world"));
+		return;
+	}
+
+	// Scatter shots out to twice the audible distance around the listener, so some of them get culled
+	FVector Center = Weapons[0]->GetComponentLocation();
+	if (const APlayerController* LocalController = World->GetFirstPlayerController())
+	{
+		FVector ListenerFront, ListenerRight;
+		LocalController->GetAudioListenerPosition(Center, ListenerFront, ListenerRight);
+	}
 
-	// Check that the character is valid, and has no weapon component yet
-	if (Character == nullptr || Character->GetInstanceComponents().FindItemByClass<UTP_WeaponComponent>())
+	int64 Played = 0, Stolen = 0, Culled = 0;
+	for (const UTP_WeaponComponent* Weapon : Weapons)
+	{
+		Played -= Weapon->TotalVoicesPlayed;
+		Stolen -= Weapon->TotalVoicesStolen;
+		Culled -= Weapon->TotalVoicesCulled;
+	}
+
+	FRandomStream Random(NumShots);
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Shot = 0; Shot < NumShots; ++Shot)
+	{
+		UTP_WeaponComponent* Weapon = Weapons[Shot % Weapons.Num()];
+		const FVector Location = Center + Random.GetUnitVector() * Random.FRandRange(0.f, 2.f * Weapon->AudibleDistance);
+		Weapon->PlayPooledSound(Weapon->FireSound, Location);
+	}
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	int32 Voices = 0;
+	for (const UTP_WeaponComponent* Weapon : Weapons)
+	{
+		Played += Weapon->TotalVoicesPlayed;
+		Stolen += Weapon->TotalVoicesStolen;
+		Culled += Weapon->TotalVoicesCulled;
+		Voices += Weapon->Voices.Num();
+	}
+
+	UE_LOG(LogDishonored, Display, TEXT("Weapon audio benchmark: %d shots through %d weapons, %lld played, %lld stolen, %lld culled, %d voices allocated, %.2f ms (%.2f us/shot)"),
+		NumShots, Weapons.Num(), Played, Stolen, Culled, Voices, ElapsedMs, ElapsedMs * 1000.0 / NumShots);
+}
+
+USkeletalMeshComponent* UTP_WeaponComponent::GetFirstPersonMesh(const ACharacter* Holder)
+{
+	if (const ADPlayerCharacter* PlayerCharacter = Cast<ADPlayerCharacter>(Holder))
+	{
+		return PlayerCharacter->GetMesh1P();
+	}
+	if (const ADishonoredCharacter* TemplateCharacter = Cast<ADishonoredCharacter>(Holder))
+	{
+		return TemplateCharacter->GetMesh1P();
+	}
+	return nullptr;
+}
+
+bool UTP_WeaponComponent::AttachWeapon(ACharacter* TargetCharacter)
+{
+	USkeletalMeshComponent* Mesh1P = GetFirstPersonMesh(TargetCharacter);
+
+	// Check that the character can hold a weapon, and has no weapon component yet
+	if (Mesh1P == nullptr || TargetCharacter->GetInstanceComponents().FindItemByClass<UTP_WeaponComponent>())
 	{
 		return false;
 	}
+	Character = TargetCharacter;
 
 	// Attach the weapon to the First Person Character
 	FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
-	AttachToComponent(Character->GetMesh1P(), AttachmentRules, FName(TEXT("GripPoint")));
+	AttachToComponent(Mesh1P, AttachmentRules, FName(TEXT("GripPoint")));
 
 	// add the weapon as an instance component to the character
 	Character->AddInstanceComponent(this);
 
+	// Clients can only send us their shots once the weapon replicates and is owned by their connection
+	AActor* WeaponActor = GetOwner();
+	if (WeaponActor->HasAuthority() && Character->HasAuthority())
+	{
+		WeaponActor->SetOwner(Character);
+		WeaponActor->SetReplicates(true);
+	}
+
 	// Set up action bindings
 	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
 	{
 		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
 		{
 			// Set the priority of the mapping to 1, so that it overrides the Jump action with the Fire action when using touch input
-			Subsystem->AddMappingContext(FireMappingContext, 1);
+			// The context lives on the local player and survives possession swaps, only add it once
+			if (!Subsystem->HasMappingContext(FireMappingContext))
+			{
+				Subsystem->AddMappingContext(FireMappingContext, 1);
+			}
 		}
 
 		if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerController->InputComponent))
@@ -104,6 +360,17 @@ bool UTP_WeaponComponent::AttachWeapon(ADishonoredCharacter* TargetCharacter)
 
 void UTP_WeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	for (UAudioComponent* Voice : Voices)
+	{
+		if (Voice != nullptr)
+		{
+			Voice->DestroyComponent();
+			DEC_DWORD_STAT(STAT_DWeaponVoicesAllocated);
+		}
+	}
+	Voices.Reset();
+	VoiceStartTimes.Reset();
+
 	if (Character == nullptr)
 	{
 		return;
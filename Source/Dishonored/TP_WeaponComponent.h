@@ -4,9 +4,21 @@
 
 #include "CoreMinimal.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Engine/NetSerialization.h"
 #include "TP_WeaponComponent.generated.h"
 
-class ADishonoredCharacter;
+class ACharacter;
+class UAudioComponent;
+
+/** How a weapon delivers its shots */
+UENUM(BlueprintType)
+enum class EWeaponFireMode : uint8
+{
+	/** Spawn a physically simulated ProjectileClass actor */
+	Projectile,
+	/** Fly the shot along a ballistic arc with batched async line traces */
+	BallisticTrace
+};
 
 UCLASS(Blueprintable, BlueprintType, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class DISHONORED_API UTP_WeaponComponent : public USkeletalMeshComponent
@@ -14,13 +26,41 @@ class DISHONORED_API UTP_WeaponComponent : public USkeletalMeshComponent
 	GENERATED_BODY()
 
 public:
-	/** Projectile class to spawn */
+	/** How shots are fired */
 	UPROPERTY(EditDefaultsOnly, Category=Projectile)
+	EWeaponFireMode FireMode;
+
+	/** Projectile class to spawn */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(EditCondition="FireMode == EWeaponFireMode::Projectile"))
 	TSubclassOf<class ADishonoredProjectile> ProjectileClass;
 
+	/** Muzzle speed of traced shots */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(EditCondition="FireMode == EWeaponFireMode::BallisticTrace"))
+	float BallisticSpeed;
+
+	/** Multiplier on world gravity for traced shots */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(EditCondition="FireMode == EWeaponFireMode::BallisticTrace"))
+	float BallisticGravityScale;
+
+	/** How long a traced shot flies before it is dropped */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(EditCondition="FireMode == EWeaponFireMode::BallisticTrace"))
+	float BallisticMaxFlightTime;
+
 	/** Sound to play each time we fire */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	USoundBase* FireSound;
+
+	/** Sound to play where our shots hit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
+	USoundBase* ImpactSound;
+
+	/** Most fire and impact sounds this weapon plays at once, the oldest voice is stolen past this */
+	UPROPERTY(EditDefaultsOnly, Category=Audio, meta=(ClampMin="1"))
+	int32 MaxVoices;
+
+	/** Sounds further than this from the listener are not played at all */
+	UPROPERTY(EditDefaultsOnly, Category=Audio)
+	float AudibleDistance;
 	
 	/** AnimMontage to play each time we fire */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
@@ -43,18 +83,51 @@ public:
 
 	/** Attaches the actor to a FirstPersonCharacter */
 	UFUNCTION(BlueprintCallable, Category="Weapon")
-	bool AttachWeapon(ADishonoredCharacter* TargetCharacter);
+	bool AttachWeapon(ACharacter* TargetCharacter);
+
+	/** Returns the first person arms of Holder a weapon attaches to, or null if it can't hold one */
+	static USkeletalMeshComponent* GetFirstPersonMesh(const ACharacter* Holder);
 
 	/** Make the weapon Fire a Projectile */
 	UFUNCTION(BlueprintCallable, Category="Weapon")
 	void Fire();
 
+	/** Plays ImpactSound at Location through this weapon's voices */
+	void PlayImpactSound(const FVector& Location);
+
+	/** Plays NumShots fire sounds around the listener through every weapon in World and logs voices, culls and time taken */
+	static void RunAudioBenchmark(UWorld* World, int32 NumShots);
+
 protected:
 	/** Ends gameplay for this component. */
 	UFUNCTION()
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
+	/** Spawns the projectile or flies the traced shot. Projectiles only spawn where the holder has authority and replicate from there */
+	void SpawnShot(const FVector& SpawnLocation, const FRotator& SpawnRotation);
+
+	/** Fires on the server for a client's shot, so projectiles exist where they are replicated from */
+	UFUNCTION(Server, Unreliable)
+	void ServerFire(FVector_NetQuantize SpawnLocation, FRotator SpawnRotation);
+
+	/** Plays Sound at Location on a pooled voice, culling by distance and stealing the oldest voice when all are busy */
+	void PlayPooledSound(USoundBase* Sound, const FVector& Location);
+
+	/** Returns true if a local player's listener is within AudibleDistance of Location, trying our holder's first */
+	bool IsAudibleLocally(const FVector& Location) const;
+
 	/** The Character holding this weapon*/
-	ADishonoredCharacter* Character;
+	ACharacter* Character;
+
+	/** Audio components reused for every fire and impact sound */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioComponent>> Voices;
+
+	/** When each entry in Voices last started playing */
+	TArray<double> VoiceStartTimes;
+
+	int64 TotalVoicesPlayed = 0;
+	int64 TotalVoicesStolen = 0;
+	int64 TotalVoicesCulled = 0;
 };